@@ -0,0 +1,887 @@
+/* emitc.c
+ * Author: Khalid Hussain
+ * --------------------
+ * This program is the compiler to C of --emit-c, which translates the nodes
+ * that interpreter.c analyzes a program into to a C file that runs it.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include "headers/linkedlist.h"
+#include "headers/value.h"
+#include "headers/talloc.h"
+#include "headers/interpreter.h"
+#include "headers/node.h"
+#include "headers/vm.h"
+#include "headers/optimize.h"
+#include "headers/emitc.h"
+
+/* The compiler to C. With --emit-c, the program is translated into a C file
+ * that runs it, linked with the rest of the interpreter for talloc, the
+ * linked lists, the primitives and eval. A define of a lambda whose body
+ * only uses what the JIT handles, or let, becomes a C function, and so does
+ * any other top-level expression that does. Everything a C function holds
+ * is in the slots of a frame on the frame stack, where the collector finds
+ * it. A call of a variable defined by one define and never assigned is a
+ * direct call of its C function, and a call of the function itself in tail
+ * position jumps back to its start. The other top-level expressions are
+ * rebuilt from their parse trees and passed to eval.
+ */
+
+/* A top-level expression compiled to a C function */
+struct cFunction {
+  Value *name; /* The variable the lambda is defined to, or NULL for an expression */
+  Node *body;
+  int params;
+  int known; /* Whether calls of the variable call the C function directly */
+  int tailCalled; /* Whether another C function calls it in tail position */
+};
+
+/* What the compiler to C keeps track of */
+struct cProgram {
+  struct cFunction *functions;
+  int functionCount;
+  int functionCapacity;
+  Value **symbols; /* The global variables the C functions look up */
+  int symbolCount;
+  int symbolCapacity;
+  Value **constants; /* The constants of the C functions that are allocated */
+  int constantCount;
+  int constantCapacity;
+  Value *defined; /* The variable of every define in the program */
+  Value *assigned; /* The variable of every set! in the program */
+  char *text; /* What has been written and not yet printed */
+  int length;
+  int capacity;
+  int indent;
+  int current; /* The C function being written, */
+  int temps; /* the slots of its frame in use, */
+  int maxSlots; /* the most that ever are, */
+  int loops; /* and whether it calls itself in tail position */
+  int tailArguments; /* The most arguments of a tail call of another C function */
+};
+
+/* A let of the C function being written, whose variables start at base */
+struct cScope {
+  int base;
+  struct cScope *outer;
+};
+
+/* The start of every C file, with the helpers its functions use */
+static const char *cPrelude =
+  "#include <stdio.h>\n"
+  "#include <stdarg.h>\n"
+  "#include <string.h>\n"
+  "#include \"headers/value.h\"\n"
+  "#include \"headers/linkedlist.h\"\n"
+  "#include \"headers/talloc.h\"\n"
+  "#include \"headers/tokenizer.h\"\n"
+  "#include \"headers/interpreter.h\"\n"
+  "#include \"headers/arithmetic.h\"\n"
+  "#include \"headers/emitc.h\"\n"
+  "\n"
+  "/* What a C function returns to have its caller make its tail call */\n"
+  "#define TAIL_CALL MAKE_CONSTANT(VOID_TYPE, 2)\n"
+  "\n"
+  "/* Every top-level expression, kept alive since what eval makes of it points into it */\n"
+  "static Value *program = NULL;\n"
+  "\n"
+  "static inline Value *keep(Value *expr) {\n"
+  "  program = cons(expr, program);\n"
+  "  return expr;\n"
+  "}\n"
+  "\n"
+  "static inline Value *datumList(int count, ...) {\n"
+  "  Value *items[count > 0 ? count : 1];\n"
+  "  Value *list = NULL_VALUE;\n"
+  "  va_list args;\n"
+  "  va_start(args, count);\n"
+  "  for (int i = 0; i < count; i++) {\n"
+  "    items[i] = va_arg(args, Value *);\n"
+  "  }\n"
+  "  va_end(args);\n"
+  "  for (int i = count - 1; i >= 0; i--) {\n"
+  "    list = cons(items[i], list);\n"
+  "  }\n"
+  "  return list;\n"
+  "}\n"
+  "\n"
+  "static inline Value *datumDouble(double d) {\n"
+  "  Value *value = tallocValue(DOUBLE_TYPE);\n"
+  "  value -> d = d;\n"
+  "  return value;\n"
+  "}\n"
+  "\n"
+  "static inline Value *datumString(const char *s) {\n"
+  "  Value *value = tallocValue(STR_TYPE);\n"
+  "  value -> s = talloc(strlen(s) + 1);\n"
+  "  strcpy(value -> s, s);\n"
+  "  return value;\n"
+  "}\n"
+  "\n"
+  "static inline void checkBinding(Value *value, const char *name, const char *let) {\n"
+  "  if (TYPE(value) == CLOSURE_TYPE || value == UNSPECIFIED_VALUE) {\n"
+  "    printf(\"Evaluation error: Unbound variable %s in %s. \\n\", name, let);\n"
+  "    texit(0);\n"
+  "  }\n"
+  "}\n";
+
+/* What makes the tail calls of C functions, after the declarations */
+static const char *cFinishCall =
+  "static inline Value *finishCall(Value *result) {\n"
+  "  while (result == TAIL_CALL) {\n"
+  "    result = tailFunction(tailArguments);\n"
+  "  }\n"
+  "  return result;\n"
+  "}\n";
+
+/* Function: isFixed
+ * --------------------
+ *   Tells whether a global variable is only ever bound to one value in the
+ *   program: it is never assigned, and defined the given number of times.
+ *
+ *   p: The compiler.
+ *   symbol: The variable.
+ *   defines: 1 for a variable of the program, 0 for a primitive.
+ *   returns: 1 if it is, 0 otherwise.
+ */
+
+static int isFixed(struct cProgram *p, Value *symbol, int defines) {
+  return countSymbol(p -> defined, symbol) == defines && countSymbol(p -> assigned, symbol) == 0;
+}
+
+/* Function: cCompilable
+ * --------------------
+ *   Tells whether the compiler to C handles a node and everything in it.
+ *
+ *   node: The node.
+ *   returns: 1 if it does, 0 otherwise.
+ */
+
+static int cCompilable(Node *node) {
+  switch (node -> kind) {
+  case CONSTANT_NODE:
+  case GLOBAL_NODE:
+    return 1;
+  case LOCAL_NODE:
+    return !LOCAL_MUTABLE(node -> value);
+  case IF_NODE:
+  case LET_NODE:
+  case BEGIN_NODE:
+  case AND_NODE:
+  case OR_NODE:
+  case COND_NODE:
+  case CALL_NODE:
+    for (int i = 0; i < node -> count; i++) {
+      if (!cCompilable(node -> children[i])) {
+        return 0;
+      }
+    }
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+/* Function: cWrite
+ * --------------------
+ *   Writes C code, formatted like printf.
+ *
+ *   p: The compiler.
+ *   format: The format.
+ */
+
+static void cWrite(struct cProgram *p, const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  int needed = vsnprintf(NULL, 0, format, args);
+  va_end(args);
+  p -> text = growBuffer(p -> text, &p -> capacity, p -> length + needed + 1, 1);
+  va_start(args, format);
+  vsnprintf(p -> text + p -> length, needed + 1, format, args);
+  va_end(args);
+  p -> length = p -> length + needed;
+}
+
+/* Function: cLine
+ * --------------------
+ *   Writes a line of C code, indented, formatted like printf.
+ *
+ *   p: The compiler.
+ *   format: The format.
+ */
+
+static void cLine(struct cProgram *p, const char *format, ...) {
+  cWrite(p, "%*s", 2 * p -> indent, "");
+  va_list args;
+  va_start(args, format);
+  int needed = vsnprintf(NULL, 0, format, args);
+  va_end(args);
+  p -> text = growBuffer(p -> text, &p -> capacity, p -> length + needed + 2, 1);
+  va_start(args, format);
+  vsnprintf(p -> text + p -> length, needed + 1, format, args);
+  va_end(args);
+  p -> length = p -> length + needed;
+  cWrite(p, "\n");
+}
+
+/* Function: cFlush
+ * --------------------
+ *   Prints what has been written.
+ *
+ *   p: The compiler.
+ */
+
+static void cFlush(struct cProgram *p) {
+  fwrite(p -> text, 1, p -> length, stdout);
+  p -> length = 0;
+}
+
+/* Function: cString
+ * --------------------
+ *   Writes a C string literal.
+ *
+ *   p: The compiler.
+ *   s: The string.
+ */
+
+static void cString(struct cProgram *p, const char *s) {
+  cWrite(p, "\"");
+  for (; *s != '\0'; s++) {
+    unsigned char ch = (unsigned char) *s;
+    if (ch == '"' || ch == '\\' || ch == '?') {
+      cWrite(p, "\\%c", ch);
+    }
+    else if (ch >= 32 && ch < 127) {
+      cWrite(p, "%c", ch);
+    }
+    else {
+      cWrite(p, "\\%03o", ch);
+    }
+  }
+  cWrite(p, "\"");
+}
+
+/* Function: cDatum
+ * --------------------
+ *   Writes a C expression that builds a datum of the parse tree.
+ *
+ *   p: The compiler.
+ *   datum: The datum.
+ */
+
+static void cDatum(struct cProgram *p, Value *datum) {
+  switch (TYPE(datum)) {
+  case INT_TYPE:
+    cWrite(p, "MAKE_FIXNUM(%ld)", (long) FIXNUM_VALUE(datum));
+    break;
+  case DOUBLE_TYPE:
+    cWrite(p, "datumDouble(%.17g)", datum -> d);
+    break;
+  case STR_TYPE:
+    cWrite(p, "datumString(");
+    cString(p, datum -> s);
+    cWrite(p, ")");
+    break;
+  case SYMBOL_TYPE:
+    cWrite(p, "intern(");
+    cString(p, datum -> s);
+    cWrite(p, ")");
+    break;
+  case BOOL_TYPE:
+    cWrite(p, datum == TRUE_VALUE ? "TRUE_VALUE" : "FALSE_VALUE");
+    break;
+  case CONS_TYPE:
+    cWrite(p, "datumList(%d", length(datum));
+    for (Value *cur = datum; IS_CONS(cur); cur = cdr(cur)) {
+      cWrite(p, ", ");
+      cDatum(p, car(cur));
+    }
+    cWrite(p, ")");
+    break;
+  default:
+    cWrite(p, "NULL_VALUE");
+    break;
+  }
+}
+
+/* Function: cIndex
+ * --------------------
+ *   Finds a symbol or constant among those the C functions use, adding it if
+ *   it isn't there yet.
+ *
+ *   items: The symbols or constants.
+ *   count: How many there are.
+ *   capacity: How many there is room for.
+ *   item: The one to find.
+ *   returns: Its index.
+ */
+
+static int cIndex(Value ***items, int *count, int *capacity, Value *item) {
+  for (int i = 0; i < *count; i++) {
+    if ((*items)[i] == item) {
+      return i;
+    }
+  }
+  *items = growBuffer(*items, capacity, *count + 1, sizeof(Value *));
+  (*items)[*count] = item;
+  *count = *count + 1;
+  return *count - 1;
+}
+
+/* Function: cKnownFunction
+ * --------------------
+ *   Finds the C function that the function of a call is known to be.
+ *
+ *   p: The compiler.
+ *   node: The node of the function.
+ *   returns: The index of the C function, or -1 if there is none.
+ */
+
+static int cKnownFunction(struct cProgram *p, Node *node) {
+  if (node -> kind != GLOBAL_NODE) {
+    return -1;
+  }
+  for (int i = 0; i < p -> functionCount; i++) {
+    if (p -> functions[i].known && p -> functions[i].name == node -> value) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/* Function: cName
+ * --------------------
+ *   Writes the name of a C function, which has the name of its variable in
+ *   it, with what C doesn't allow in a name replaced.
+ *
+ *   p: The compiler.
+ *   prefix: What kind of name it is.
+ *   index: The index of the C function.
+ */
+
+static void cName(struct cProgram *p, const char *prefix, int index) {
+  Value *name = p -> functions[index].name;
+  cWrite(p, "%s%d", prefix, index);
+  if (name != NULL) {
+    cWrite(p, "_");
+    for (char *ch = name -> s; *ch != '\0'; ch++) {
+      cWrite(p, "%c", (*ch >= 'a' && *ch <= 'z') || (*ch >= 'A' && *ch <= 'Z') || (*ch >= '0' && *ch <= '9') ? *ch : '_');
+    }
+  }
+}
+
+/* Function: cReserve
+ * --------------------
+ *   Takes slots of the frame of the C function being written.
+ *
+ *   p: The compiler.
+ *   count: How many.
+ *   returns: The first one; they are given back by resetting p -> temps to it.
+ */
+
+static int cReserve(struct cProgram *p, int count) {
+  int first = p -> temps;
+  p -> temps = p -> temps + count;
+  if (p -> temps > p -> maxSlots) {
+    p -> maxSlots = p -> temps;
+  }
+  return first;
+}
+
+static void cNode(struct cProgram *p, Node *node, struct cScope *scope, const char *target, int tail);
+
+/* Function: cArguments
+ * --------------------
+ *   Writes the evaluation of some of the children of a call into slots of
+ *   the frame, one after the other.
+ *
+ *   p: The compiler.
+ *   node: The CALL_NODE.
+ *   from: The first child.
+ *   scope: The innermost let, or NULL.
+ *   returns: The slot of the first one.
+ */
+
+static int cArguments(struct cProgram *p, Node *node, int from, struct cScope *scope) {
+  int first = cReserve(p, node -> count - from);
+  for (int i = from; i < node -> count; i++) {
+    char slot[32];
+    snprintf(slot, sizeof(slot), "frame -> slots[%d]", first + i - from);
+    cNode(p, node -> children[i], scope, slot, 0);
+  }
+  return first;
+}
+
+/* Function: cCall
+ * --------------------
+ *   Writes a call: arithmetic on fixnums right there, a known function
+ *   through a direct call of its C function, or in tail position, a jump
+ *   back to the start for the function calling itself and a return of
+ *   TAIL_CALL otherwise, and anything else through applyFunction.
+ *
+ *   p: The compiler.
+ *   node: The CALL_NODE.
+ *   scope: The innermost let, or NULL.
+ *   target: Where the result goes.
+ *   tail: Whether the call is in tail position.
+ */
+
+static void cCall(struct cProgram *p, Node *node, struct cScope *scope, const char *target, int tail) {
+  static char *helpers[] = {"numberAddInline", "numberMinusInline", "numberLessThanInline", "numberGreaterThanInline", "numberEqualInline"};
+  int temps = p -> temps;
+  int op = arithmeticOpcode(node);
+  int callee = cKnownFunction(p, node -> children[0]);
+  int count = node -> count - 1;
+
+  if (op >= 0 && isFixed(p, node -> children[0] -> value, 0)) {
+    int first = cArguments(p, node, 1, scope);
+    cLine(p, "%s = %s(frame -> slots[%d], frame -> slots[%d]);", target, helpers[op - OP_ADD], first, first + 1);
+  }
+  else if (callee >= 0) {
+    struct cFunction *function = &p -> functions[callee];
+    if (callee != p -> current) {
+      // Until its define has run, the variable is unbound, as it is for eval.
+      cWrite(p, "%*sif (", 2 * p -> indent, "");
+      cName(p, "closure", callee);
+      cWrite(p, " == NULL) {\n");
+      cLine(p, "  globalValue(symbol%d);", cIndex(&p -> symbols, &p -> symbolCount, &p -> symbolCapacity, function -> name));
+      cLine(p, "}");
+    }
+    int first = cArguments(p, node, 1, scope);
+    if (tail && callee != p -> current && p -> functions[p -> current].name != NULL) {
+      // The caller returns first, so calls going back and forth in tail
+      // position don't grow the C stack.
+      for (int i = 0; i < function -> params; i++) {
+        if (i < count) {
+          cLine(p, "tailArguments[%d] = frame -> slots[%d];", i, first + i);
+        }
+        else {
+          cLine(p, "tailArguments[%d] = NULL_VALUE;", i);
+        }
+      }
+      cWrite(p, "%*stailFunction = ", 2 * p -> indent, "");
+      cName(p, "enter", callee);
+      cWrite(p, ";\n");
+      cLine(p, "%s = TAIL_CALL;", target);
+      function -> tailCalled = 1;
+      if (function -> params > p -> tailArguments) {
+        p -> tailArguments = function -> params;
+      }
+    }
+    else if (tail && callee == p -> current) {
+      for (int i = 0; i < function -> params; i++) {
+        if (i < count) {
+          cLine(p, "frame -> slots[%d] = frame -> slots[%d];", i, first + i);
+        }
+        else {
+          cLine(p, "frame -> slots[%d] = NULL_VALUE;", i);
+        }
+      }
+      cLine(p, "goto top;");
+      p -> loops = 1;
+    }
+    else {
+      cWrite(p, "%*s%s = finishCall(", 2 * p -> indent, "", target);
+      cName(p, "function", callee);
+      cWrite(p, "(");
+      for (int i = 0; i < function -> params; i++) {
+        if (i < count) {
+          cWrite(p, i > 0 ? ", frame -> slots[%d]" : "frame -> slots[%d]", first + i);
+        }
+        else {
+          cWrite(p, i > 0 ? ", NULL_VALUE" : "NULL_VALUE");
+        }
+      }
+      cWrite(p, "));\n");
+    }
+  }
+  else {
+    int first = cArguments(p, node, 0, scope);
+    cLine(p, "%s = applyFunction(frame -> slots[%d], &frame -> slots[%d], %d);", target, first, first + 1, count);
+  }
+  p -> temps = temps;
+}
+
+/* Function: cNode
+ * --------------------
+ *   Writes the C code that evaluates a node.
+ *
+ *   p: The compiler.
+ *   node: The node.
+ *   scope: The innermost let, or NULL.
+ *   target: Where the value goes: a slot of the frame, or the result.
+ *   tail: Whether the node is in tail position.
+ */
+
+static void cNode(struct cProgram *p, Node *node, struct cScope *scope, const char *target, int tail) {
+  int depth, first;
+  struct cScope *holder = scope;
+  Value *binding;
+
+  switch (node -> kind) {
+  case CONSTANT_NODE:
+    if (IS_POINTER(node -> value)) {
+      cLine(p, "%s = constant%d;", target,
+            cIndex(&p -> constants, &p -> constantCount, &p -> constantCapacity, node -> value));
+    }
+    else {
+      cWrite(p, "%*s%s = ", 2 * p -> indent, "", target);
+      cDatum(p, node -> value);
+      cWrite(p, ";\n");
+    }
+    break;
+
+  case LOCAL_NODE:
+    for (depth = LOCAL_DEPTH(node -> value); depth > 0 && holder != NULL; depth--) {
+      holder = holder -> outer;
+    }
+    cLine(p, "%s = frame -> slots[%d];", target, (holder != NULL ? holder -> base : 0) + LOCAL_SLOT(node -> value));
+    break;
+
+  case GLOBAL_NODE:
+    cLine(p, "%s = globalValue(symbol%d);", target,
+          cIndex(&p -> symbols, &p -> symbolCount, &p -> symbolCapacity, node -> value));
+    break;
+
+  case IF_NODE:
+    cNode(p, node -> children[0], scope, target, 0);
+    cLine(p, "if (IS_TRUE(%s)) {", target);
+    p -> indent = p -> indent + 1;
+    cNode(p, node -> children[1], scope, target, tail);
+    p -> indent = p -> indent - 1;
+    cLine(p, "}");
+    cLine(p, "else {");
+    p -> indent = p -> indent + 1;
+    cNode(p, node -> children[2], scope, target, tail);
+    p -> indent = p -> indent - 1;
+    cLine(p, "}");
+    break;
+
+  case LET_NODE: {
+    first = cReserve(p, node -> slots);
+    binding = node -> value;
+    for (int i = 0; i < node -> slots; i++) {
+      char slot[32];
+      snprintf(slot, sizeof(slot), "frame -> slots[%d]", first + i);
+      cNode(p, node -> children[i], scope, slot, 0);
+      cWrite(p, "%*scheckBinding(%s, ", 2 * p -> indent, "", slot);
+      cString(p, car(car(binding)) -> s);
+      cWrite(p, ", ");
+      cString(p, node -> text);
+      cWrite(p, ");\n");
+      binding = cdr(binding);
+    }
+    struct cScope inner = {first, scope};
+    cNode(p, node -> children[node -> slots], &inner, target, tail);
+    p -> temps = first;
+    break;
+  }
+
+  case BEGIN_NODE:
+    if (node -> count == 0) {
+      cLine(p, "%s = VOID_VALUE;", target);
+    }
+    for (int i = 0; i < node -> count; i++) {
+      cNode(p, node -> children[i], scope, target, tail && i == node -> count - 1);
+    }
+    break;
+
+  case AND_NODE:
+  case OR_NODE:
+    if (node -> count == 0) {
+      cLine(p, "%s = %s;", target, node -> kind == AND_NODE ? "TRUE_VALUE" : "FALSE_VALUE");
+      break;
+    }
+    for (int i = 0; i < node -> count; i++) {
+      if (i > 0) {
+        cLine(p, node -> kind == AND_NODE ? "if (IS_TRUE(%s)) {" : "if (!IS_TRUE(%s)) {", target);
+        p -> indent = p -> indent + 1;
+      }
+      cNode(p, node -> children[i], scope, target, tail && i == node -> count - 1);
+    }
+    for (int i = 1; i < node -> count; i++) {
+      p -> indent = p -> indent - 1;
+      cLine(p, "}");
+    }
+    break;
+
+  case COND_NODE:
+    for (int i = 0; i < node -> count; i += 2) {
+      cNode(p, node -> children[i], scope, target, 0);
+      cLine(p, "if (IS_TRUE(%s)) {", target);
+      p -> indent = p -> indent + 1;
+      cNode(p, node -> children[i + 1], scope, target, tail);
+      p -> indent = p -> indent - 1;
+      cLine(p, "}");
+      cLine(p, "else {");
+      p -> indent = p -> indent + 1;
+    }
+    cLine(p, "%s = VOID_VALUE;", target);
+    for (int i = 0; i < node -> count; i += 2) {
+      p -> indent = p -> indent - 1;
+      cLine(p, "}");
+    }
+    break;
+
+  case CALL_NODE:
+    cCall(p, node, scope, target, tail);
+    break;
+
+  default:
+    break;
+  }
+}
+
+/* Function: cPrototype
+ * --------------------
+ *   Writes the start of the definition of a C function, without the ';' or
+ *   '{' that follows.
+ *
+ *   p: The compiler.
+ *   index: The index of the C function.
+ */
+
+static void cPrototype(struct cProgram *p, int index) {
+  cWrite(p, "static Value *");
+  cName(p, "function", index);
+  cWrite(p, "(");
+  for (int i = 0; i < p -> functions[index].params; i++) {
+    cWrite(p, i > 0 ? ", Value *arg%d" : "Value *arg%d", i);
+  }
+  cWrite(p, p -> functions[index].params == 0 ? "void)" : ")");
+}
+
+/* Function: cFunctionBody
+ * --------------------
+ *   Writes a C function, and for a lambda, the node handler that calls it for
+ *   its closure.
+ *
+ *   p: The compiler.
+ *   index: The index of the C function.
+ */
+
+static void cFunctionBody(struct cProgram *p, int index) {
+  struct cFunction *function = &p -> functions[index];
+  p -> current = index;
+  p -> temps = function -> params;
+  p -> maxSlots = function -> params;
+  p -> loops = 0;
+  p -> indent = 1;
+
+  // The body is written first, since the size of the frame depends on it.
+  int start = p -> length;
+  cNode(p, function -> body, NULL, "result", 1);
+  char *body = malloc(p -> length - start + 1);
+  memcpy(body, p -> text + start, p -> length - start);
+  body[p -> length - start] = '\0';
+  p -> length = start;
+
+  cPrototype(p, index);
+  cWrite(p, " {\n");
+  cLine(p, "void *mark = stackMark();");
+  cLine(p, "Frame *frame = tallocStackFrame(%d);", p -> maxSlots);
+  cLine(p, "Value *result = VOID_VALUE;");
+  cLine(p, "gcProtect(&frame);");
+  for (int i = 0; i < function -> params; i++) {
+    cLine(p, "frame -> slots[%d] = arg%d;", i, i);
+  }
+  if (p -> loops) {
+    cWrite(p, "top:\n");
+  }
+  cLine(p, "gcSafePoint();");
+  cWrite(p, "%s", body);
+  cLine(p, "gcUnprotect(1);");
+  cLine(p, "stackRelease(mark);");
+  cLine(p, "return result;");
+  cWrite(p, "}\n\n");
+  free(body);
+
+  if (function -> name != NULL) {
+    cWrite(p, "static Value *");
+    cName(p, "run", index);
+    cWrite(p, "(struct Node *node, Frame *frame) {\n  return finishCall(");
+    cName(p, "function", index);
+    cWrite(p, "(");
+    for (int i = 0; i < function -> params; i++) {
+      cWrite(p, i > 0 ? ", frame -> slots[%d]" : "frame -> slots[%d]", i);
+    }
+    cWrite(p, "));\n}\n\n");
+  }
+}
+
+/* Function: defineCompiled
+ * --------------------
+ *   Evaluates the define of a lambda that was compiled to C, and makes the
+ *   closure it binds run the C function instead of the body, through a
+ *   NATIVE_NODE, so the closure is the same for any other code that calls it.
+ *
+ *   expr: The define expression.
+ *   run: The handler that calls the C function with the slots of the frame.
+ *   returns: The closure.
+ */
+
+Value *defineCompiled(Value *expr, Value *(*run)(struct Node *node, Frame *frame)) {
+  eval(expr);
+  Value *closure = globalValue(car(cdr(expr)));
+  Node *lambda = closure -> cl.lambda;
+  Node *native = makeNode(NATIVE_NODE, run, 1, lambda -> children[0] -> source);
+  native -> slots = lambda -> slots;
+  native -> children[0] = lambda -> children[0];
+  lambda -> children[0] = native;
+  return closure;
+}
+
+/* Function: emitProgram
+ * --------------------
+ *   Translates a program into a C file that runs it, printed to stdout, for
+ *   --emit-c. The C file is built from the directory of the interpreter with
+ *   its sources other than main.c, for example:
+ *     cc -O2 -o program program.c linkedlist.c talloc.c tokenizer.c parser.c interpreter.c vm.c jit.c emitc.c optimize.c
+ *
+ *   tree: The tree of parsed Scheme expressions.
+ */
+
+void emitProgram(Value *tree) {
+  struct cProgram p = {0};
+  startInterpreter();
+  p.defined = collectDefined(tree, makeNull());
+  p.assigned = collectAssigned(tree, makeNull());
+  startOptimizer(tree);
+
+  // Each top-level expression is compiled, or it is left for eval, which
+  // its function is -1 for.
+  int forms = length(tree);
+  int *functionOf = malloc(sizeof(int) * (forms > 0 ? forms : 1));
+  Value *cur = tree;
+  for (int i = 0; i < forms; i++) {
+    Node *node = analyzeTopLevel(car(cur));
+    struct cFunction function = {.body = node};
+    functionOf[i] = -1;
+    if (node -> kind == DEFINE_NODE && node -> children[0] -> kind == LAMBDA_NODE) {
+      Node *lambda = node -> children[0];
+      function.name = node -> value;
+      function.body = lambda -> children[0];
+      function.params = lambda -> slots;
+      // A primitive is bound before its define, so only a variable that
+      // starts out unbound can be known.
+      function.known = isFixed(&p, node -> value, 1) && globalCell(node -> value) == NULL;
+    }
+    if (node -> kind != DEFINE_NODE || function.name != NULL) {
+      if (cCompilable(function.body)) {
+        p.functions = growBuffer(p.functions, &p.functionCapacity, p.functionCount + 1, sizeof(struct cFunction));
+        p.functions[p.functionCount] = function;
+        functionOf[i] = p.functionCount;
+        p.functionCount = p.functionCount + 1;
+      }
+    }
+    cur = cdr(cur);
+  }
+
+  // The functions are written first, to find the symbols and constants
+  // they use, which are declared before them.
+  for (int i = 0; i < p.functionCount; i++) {
+    cFunctionBody(&p, i);
+  }
+  char *functions = malloc(p.length + 1);
+  memcpy(functions, p.text, p.length);
+  functions[p.length] = '\0';
+  p.length = 0;
+
+  printf("/* Compiled from Scheme by interpreter --emit-c. */\n\n%s\n", cPrelude);
+  for (int i = 0; i < p.symbolCount; i++) {
+    cWrite(&p, "static Value *symbol%d;\n", i);
+  }
+  for (int i = 0; i < p.constantCount; i++) {
+    cWrite(&p, "static Value *constant%d;\n", i);
+  }
+  cWrite(&p, "\n/* The tail call a C function returned TAIL_CALL for */\n");
+  cWrite(&p, "static Value *(*tailFunction)(Value **args) = NULL;\n");
+  cWrite(&p, "static Value *tailArguments[%d];\n\n", p.tailArguments > 0 ? p.tailArguments : 1);
+  cWrite(&p, "%s\n", cFinishCall);
+  for (int i = 0; i < p.functionCount; i++) {
+    if (p.functions[i].known) {
+      cWrite(&p, "static Value *");
+      cName(&p, "closure", i);
+      cWrite(&p, " = NULL;\n");
+    }
+    cPrototype(&p, i);
+    cWrite(&p, ";\n");
+    if (p.functions[i].tailCalled) {
+      cWrite(&p, "static Value *");
+      cName(&p, "enter", i);
+      cWrite(&p, "(Value **args);\n");
+    }
+  }
+  cWrite(&p, "\n%s", functions);
+  free(functions);
+
+  for (int i = 0; i < p.functionCount; i++) {
+    if (p.functions[i].tailCalled) {
+      cWrite(&p, "static Value *");
+      cName(&p, "enter", i);
+      cWrite(&p, "(Value **args) {\n  return ");
+      cName(&p, "function", i);
+      cWrite(&p, "(");
+      for (int j = 0; j < p.functions[i].params; j++) {
+        cWrite(&p, j > 0 ? ", args[%d]" : "args[%d]", j);
+      }
+      cWrite(&p, ");\n}\n\n");
+    }
+  }
+
+  p.indent = 1;
+  cWrite(&p, "int main() {\n");
+  cLine(&p, "startInterpreter();");
+  cLine(&p, "gcAddRoot(&program);");
+  for (int i = 0; i < p.symbolCount; i++) {
+    cWrite(&p, "  symbol%d = intern(", i);
+    cString(&p, p.symbols[i] -> s);
+    cWrite(&p, ");\n");
+  }
+  for (int i = 0; i < p.constantCount; i++) {
+    cWrite(&p, "  constant%d = ", i);
+    cDatum(&p, p.constants[i]);
+    cWrite(&p, ";\n");
+    cLine(&p, "gcAddRoot(&constant%d);", i);
+  }
+  cur = tree;
+  for (int i = 0; i < forms; i++) {
+    int index = functionOf[i];
+    if (index >= 0 && p.functions[index].name != NULL) {
+      cWrite(&p, "  ");
+      if (p.functions[index].known) {
+        cName(&p, "closure", index);
+        cWrite(&p, " = ");
+      }
+      cWrite(&p, "defineCompiled(keep(");
+      cDatum(&p, car(cur));
+      cWrite(&p, "), ");
+      cName(&p, "run", index);
+      cWrite(&p, ");\n");
+    }
+    else if (index >= 0) {
+      cWrite(&p, "  printResult(finishCall(");
+      cName(&p, "function", index);
+      cWrite(&p, "()));\n");
+    }
+    else {
+      cWrite(&p, "  printResult(eval(keep(");
+      cDatum(&p, car(cur));
+      cWrite(&p, ")));\n");
+    }
+    cur = cdr(cur);
+  }
+  cLine(&p, "tfree();");
+  cLine(&p, "return 0;");
+  cWrite(&p, "}\n");
+  cFlush(&p);
+
+  free(functionOf);
+  free(p.functions);
+  free(p.symbols);
+  free(p.constants);
+  free(p.text);
+}
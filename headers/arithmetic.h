@@ -0,0 +1,67 @@
+#include "value.h"
+
+#ifndef _ARITHMETIC
+#define _ARITHMETIC
+
+// The arithmetic and comparisons of two numbers. Each operation has an entry
+// point for any two arguments, which dispatches on the types of both at once
+// and is defined in interpreter.c, and these inline ones, shared by the
+// primitives, the virtual machine and the C files made by --emit-c, so that
+// every one of them takes the same fast path on fixnums.
+
+Value *numberAdd(Value *a, Value *b);
+Value *numberMinus(Value *a, Value *b);
+Value *numberMultiply(Value *a, Value *b);
+Value *numberLessThan(Value *a, Value *b);
+Value *numberGreaterThan(Value *a, Value *b);
+Value *numberEqual(Value *a, Value *b);
+
+// The entry point for two fixnums of an arithmetic operation, whose overflow
+// check is __builtin_<builtin>_overflow. It returns NULL when the result
+// doesn't fit in a fixnum, which the dispatching entry point then works out
+// in doubles instead.
+#define FIXNUM_ARITHMETIC(name, builtin)                                       \
+    static inline Value *name##Fixnums(Value *a, Value *b) {                   \
+        intptr_t result;                                                       \
+        if (__builtin_##builtin##_overflow(FIXNUM_VALUE(a), FIXNUM_VALUE(b), &result) \
+            || !FITS_FIXNUM(result)) {                                         \
+            return NULL;                                                       \
+        }                                                                      \
+        return MAKE_FIXNUM(result);                                            \
+    }
+
+// The entry point for two fixnums of a comparison. Tagged fixnums compare the
+// same way as the integers they hold.
+#define FIXNUM_COMPARISON(name, operator)                                      \
+    static inline Value *name##Fixnums(Value *a, Value *b) {                   \
+        return MAKE_BOOL((intptr_t) a operator (intptr_t) b);                  \
+    }
+
+// The entry point for compiled code, which takes the fast path when both
+// arguments are fixnums, and falls back on the dispatching entry point.
+#define INLINE_ENTRY_POINT(name)                                               \
+    static inline Value *name##Inline(Value *a, Value *b) {                    \
+        if (IS_FIXNUM(a) && IS_FIXNUM(b)) {                                    \
+            Value *result = name##Fixnums(a, b);                               \
+            if (result != NULL) {                                              \
+                return result;                                                 \
+            }                                                                  \
+        }                                                                      \
+        return name(a, b);                                                     \
+    }
+
+FIXNUM_ARITHMETIC(numberAdd, add)
+FIXNUM_ARITHMETIC(numberMinus, sub)
+FIXNUM_ARITHMETIC(numberMultiply, mul)
+FIXNUM_COMPARISON(numberLessThan, <)
+FIXNUM_COMPARISON(numberGreaterThan, >)
+FIXNUM_COMPARISON(numberEqual, ==)
+
+INLINE_ENTRY_POINT(numberAdd)
+INLINE_ENTRY_POINT(numberMinus)
+INLINE_ENTRY_POINT(numberMultiply)
+INLINE_ENTRY_POINT(numberLessThan)
+INLINE_ENTRY_POINT(numberGreaterThan)
+INLINE_ENTRY_POINT(numberEqual)
+
+#endif
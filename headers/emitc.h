@@ -0,0 +1,9 @@
+#include "value.h"
+
+#ifndef _EMITC
+#define _EMITC
+
+void emitProgram(Value *tree);
+Value *defineCompiled(Value *expr, Value *(*run)(struct Node *node, Frame *frame));
+
+#endif
@@ -2,20 +2,30 @@
 #define _INTERPRETER
 
 void interpret(Value *tree);
-void bind(char *name, Value *(*function)(struct Value *), Frame *frame);
-Value *primitiveAdd(Value *args);
-Value *primitiveMinus(Value *args);
-Value *primitiveEqual(Value *args);
-Value *primitiveMultiply(Value *args);
-Value *primitiveDivide(Value *args);
-Value *primitiveModulo(Value *args);
-Value *primitiveCons(Value *args);
-Value *primitiveNull(Value *args);
-Value *primitiveCar(Value *args);
-Value *primitiveCdr(Value *args);
-Value *primitiveGreaterThan(Value *args);
-Value *primitiveLessThan(Value *args);
-Value *eval(Value *expr, Frame *frame);
+void startInterpreter();
+void printResult(Value *result);
+void setRegionMode(int enabled);
+void setVmMode(int enabled);
+void setJitMode(int enabled);
+void setHeapProfile();
+void printHeapProfile(int top);
+void bind(char *name, Value *(*function)(int argc, Value **argv), int minArgs, int maxArgs, char *arityError);
+Value *primitiveAdd(int argc, Value **argv);
+Value *primitiveMinus(int argc, Value **argv);
+Value *primitiveEqual(int argc, Value **argv);
+Value *primitiveMultiply(int argc, Value **argv);
+Value *primitiveDivide(int argc, Value **argv);
+Value *primitiveModulo(int argc, Value **argv);
+Value *primitiveCons(int argc, Value **argv);
+Value *primitiveNull(int argc, Value **argv);
+Value *primitiveCar(int argc, Value **argv);
+Value *primitiveCdr(int argc, Value **argv);
+Value *primitiveGreaterThan(int argc, Value **argv);
+Value *primitiveLessThan(int argc, Value **argv);
+Value *primitiveMemoryStats(int argc, Value **argv);
+Value *eval(Value *expr);
+Value *globalValue(Value *symbol);
+Value *applyFunction(Value *function, Value **args, int count);
 
 #endif
 
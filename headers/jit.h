@@ -0,0 +1,9 @@
+#include "node.h"
+
+#ifndef _JIT
+#define _JIT
+
+Node *hotBody(Node *lambda);
+void printJitStats();
+
+#endif
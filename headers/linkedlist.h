@@ -32,6 +32,10 @@ Value *cdr(Value *list);
 // that this is a legitimate operation.
 bool isNull(Value *value);
 
+// Create a proper list of the given length as one contiguous cdr-coded run,
+// with every element the empty list until it is set through its car.
+Value *makeList(int count);
+
 // Measure length of list. Use assertions to make sure that this is a legitimate
 // operation.
 int length(Value *value);
@@ -0,0 +1,72 @@
+#include "value.h"
+
+#ifndef _NODE
+#define _NODE
+
+// The tree of nodes that the analysis pass in interpreter.c turns each
+// expression into, and what of the interpreter the other ways of running it,
+// the virtual machine, the JIT, the compiler to C and the optimizer, share.
+
+/* A mutable variable captured by a closure is moved into a box, a frame of one
+ * slot, that its own frame and the closure's share. Frames are never values,
+ * so a box can't be mistaken for the value of a variable. */
+#define IS_BOX(v) (IS_POINTER(v) && ((struct header *) (v))[-1].kind == FRAME_KIND)
+
+/* What a handler returns instead of evaluating the expression in its tail
+ * position, which inTail leaves for execute to evaluate next. It is never
+ * the value of an expression. */
+#define TAIL_VALUE MAKE_CONSTANT(VOID_TYPE, 1)
+
+/* The kinds of node that the analysis pass turns expressions into. */
+typedef enum {
+  CONSTANT_NODE, LOCAL_NODE, GLOBAL_NODE, IF_NODE, LET_NODE, LETREC_NODE,
+  SET_LOCAL_NODE, SET_GLOBAL_NODE, DEFINE_NODE, LAMBDA_NODE, BEGIN_NODE,
+  AND_NODE, OR_NODE, COND_NODE, CALL_NODE, ERROR_NODE, NATIVE_NODE
+} nodeKind;
+
+typedef struct Node Node;
+typedef struct Code Code;
+typedef Value *(*nodeHandler)(Node *node, Frame *frame);
+
+/* An analyzed expression: what kind it is, the handler that evaluates it,
+ * and its parts, already checked, so evaluating it never looks at the syntax
+ * again. Nodes live as long as the interpreter, like symbols. Besides other
+ * nodes, they only point to symbols and into the parse tree, which interpret
+ * keeps alive, so the collector doesn't need to trace them.
+ */
+
+struct Node {
+  nodeHandler run; /* Evaluates the node */
+  nodeKind kind;
+  int count; /* The number of children */
+  int slots; /* The size of the frame it makes, for a lambda, let or letrec */
+  Value *value; /* The constant, variable, local address, parameters or bindings */
+  Value *source; /* The expression it was analyzed from */
+  char *text; /* The message of an error, or the name of a let or let* */
+  Code *code; /* The bytecode of the body of a lambda, once compiled for the virtual machine */
+  int calls; /* How many times a lambda was applied, or its machine code run */
+  Node *children[];
+};
+
+extern Frame *globalframe;
+extern int heapProfiling;
+extern Value *defineSymbol;
+
+Node *makeNode(nodeKind kind, nodeHandler run, int count, Value *source);
+Node *constantNode(Value *value, Value *source);
+Node *analyzeTopLevel(Value *expr);
+Value *execute(Node *node, Frame *frame);
+Value *inTail(Node *node, Frame *frame, int call);
+Value *runLambda(Node *node, Frame *frame);
+Value *applyPrimitive(Value *function, Value **args, int count, Node *call);
+Frame *callFrame(Value *function, Node *body, Value **args, int count, Node *call);
+Frame *frameAt(Frame *frame, int depth);
+Value **globalCell(Value *symbol);
+void defineGlobal(Value *symbol, Value *value);
+Value *collectAssigned(Value *expr, Value *assigned);
+Value *collectDefined(Value *expr, Value *defined);
+int countSymbol(Value *list, Value *symbol);
+void describeSite(Value *site, char *buffer, size_t size);
+void *growBuffer(void *buffer, int *capacity, int needed, size_t size);
+
+#endif
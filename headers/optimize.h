@@ -0,0 +1,12 @@
+#include "node.h"
+
+#ifndef _OPTIMIZE
+#define _OPTIMIZE
+
+void setOptMode(int enabled);
+void setOptReport();
+void startOptimizer(Value *tree);
+Node *optimizeTopLevel(Value *expr, Node *node);
+void printOptReport();
+
+#endif
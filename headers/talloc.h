@@ -4,20 +4,185 @@
 #ifndef _TALLOC
 #define _TALLOC
 
-struct node {
-   void *data;
-   struct node *next;
+// A chunk of memory that talloc hands out pointers from. Pointers are bumped
+// from top towards limit; chunks are chained together so they can all be
+// released at once.
+struct chunk {
+   struct chunk *next;
+   char *top;
+   char *limit;
+   char data[];
 };
 
-// Replacement for malloc that stores the pointers allocated. It should store
-// the pointers in some kind of list; a linked list would do fine, but insert
-// here whatever code you'll need to do so; don't call functions in the
-// pre-existing linkedlist.h. Otherwise you'll end up with circular
-// dependencies, since you're going to modify the linked list to use talloc.
+// What a pointer allocated by talloc holds, so that the garbage collector
+// knows which other pointers it has to follow from it.
+typedef enum {
+   RAW_KIND, VALUE_KIND, FRAME_KIND, FREE_KIND
+} allocKind;
+
+// Every pointer handed out by talloc is preceded by one of these. The size
+// doesn't count the header itself, and is always a multiple of 8 bytes. The
+// type of a Value lives here rather than in the Value struct; it has to stay
+// the last byte, right in front of the pointer, since that's where TYPE()
+// looks for it.
+struct header {
+   unsigned int size;
+   unsigned char kind;
+   unsigned char mark;
+   unsigned char flags;
+   unsigned char type;
+};
+
+// How many pointers of one sort talloc has handed out, and how many of those
+// are still in use, meaning not yet reclaimed. Bytes include the headers.
+struct memoryCounter {
+   size_t allocatedObjects;
+   size_t allocatedBytes;
+   size_t liveObjects;
+   size_t liveBytes;
+};
+
+// There is a counter for each valueType, plus one for Frames and one for raw
+// bytes.
+#define FRAME_COUNTER (UNSPECIFIED_TYPE + 1)
+#define RAW_COUNTER (UNSPECIFIED_TYPE + 2)
+#define MEMORY_COUNTERS (UNSPECIFIED_TYPE + 3)
+
+// Set in the flags of a pointer allocated while a region is open, and of one
+// that has since been copied out of the region when it closed.
+#define REGION_FLAG 1
+#define FORWARDED_FLAG 2
+
+// Set in the flags of a pointer on the frame stack, which the collector
+// traces but never reclaims.
+#define STACK_FLAG 4
+
+// Set in the flags of a cons cell of a run made by tallocList, other than the
+// last one. Its cdr is the cell right after it rather than a field, and the
+// size in its header is the number of cells after it in the run.
+#define CDR_NEXT_FLAG 8
+
+// Replacement for malloc that hands out pointers from large chunks. The
+// pointer holds raw bytes, such as a string, that aren't looked inside of by
+// the garbage collector. Don't call functions in the pre-existing
+// linkedlist.h. Otherwise you'll end up with circular dependencies, since the
+// linked list uses talloc.
 void *talloc(size_t size);
 
-// Free all pointers allocated by talloc, as well as whatever memory you
-// allocated in lists to hold those pointers.
+// Same as talloc, for a pointer of the given kind.
+void *tallocKind(size_t size, allocKind kind);
+
+// Allocates a zeroed Value struct of the given type, only as large as the
+// union member that type uses.
+Value *tallocValue(valueType type);
+
+// Allocates a proper list of count cons cells as a single cdr-coded run, with
+// every car the empty list. makeList in linkedlist.h also handles length 0.
+Value *tallocList(int count);
+
+// Allocates a Frame struct with the given number of slots, with no parent and
+// every slot the empty list.
+Frame *tallocFrame(int size);
+
+// Same as tallocFrame, but on the frame stack, a LIFO region that is released
+// with stackRelease instead of by the collector. Nothing on the heap may point
+// to something on the frame stack once it is released.
+Frame *tallocStackFrame(int size);
+
+// The top of the frame stack, and releasing everything put on it since.
+void *stackMark();
+void stackRelease(void *mark);
+
+// Moves the last frame put on the frame stack down to a mark, releasing
+// everything in between, for a tail call.
+Frame *stackMoveFrame(Frame *frame, void *mark);
+
+// Same as talloc and tallocValue, but the pointer is never reclaimed nor moved,
+// for something that lives as long as the interpreter, such as an interned
+// symbol. The collector doesn't trace it, so it may only point to other
+// permanent pointers.
+void *tallocPermanent(size_t size);
+Value *tallocPermanentValue(valueType type);
+
+// Registers the address of a global variable as a root of the garbage
+// collector, so whatever it points to is never reclaimed.
+void gcAddRoot(void *slot);
+
+// Registers a table that holds pointers without keeping them alive, such as
+// the span table of the tokenizer. Every collection calls prune after marking,
+// which drops the entries for which gcIsLive returns 0, before they are swept.
+void gcAddWeakTable(void (*prune)());
+int gcIsLive(void *pointer);
+
+// Pushes the address of a local variable, so whatever it points to is not
+// reclaimed until the matching gcUnprotect. Any pointer held while a node is
+// evaluated has to be protected, since collections happen at the safe point of
+// execute in interpreter.c.
+void gcProtect(void *slot);
+
+// Pops the given number of addresses pushed by gcProtect.
+void gcUnprotect(int count);
+
+// Collects garbage if the heap has grown past the threshold set by the
+// heap-growth policy. Every pointer still needed must be reachable from a
+// root or a protected address when this is called.
+void gcSafePoint();
+
+// Runs a full collection right away.
+void gcCollect();
+
+// Sets the heap-growth policy: whether to collect at all, the heap size below
+// which there are no collections, and how much the heap may grow relative to
+// what survived the last collection before collecting again.
+void gcConfigure(int enabled, size_t minHeap, double growth);
+
+// Must be called whenever a pointer is written into a pointer that may have
+// been allocated before the open region, such as a binding of the global
+// frame, so that it is kept when the region closes.
+void gcWriteBarrier(void *holder, void *pointer);
+
+// Opens a region: everything allocated until regionEnd belongs to it.
+void regionBegin();
+
+// Closes the open region, reclaiming everything allocated in it except what
+// escaped through a write recorded by gcWriteBarrier or is held by a root or
+// protected slot, which is copied out.
+void regionEnd();
+
+// Prints the number of collections, pause times and bytes reclaimed to stderr.
+void gcPrintStats();
+
+// The MEMORY_COUNTERS memory counters, and the name of each one.
+const struct memoryCounter *memoryCounters();
+const char *memoryCounterName(int counter);
+
+// The bytes currently in use, and the most that ever were at once.
+size_t memoryLiveBytes();
+size_t memoryPeakBytes();
+
+// The most bytes that were ever in use on the frame stack at once.
+size_t stackPeakBytes();
+
+// Prints the memory counters to stderr.
+void memPrintReport();
+
+// What the heap profiler charged to one allocation site. A site is whatever
+// was passed to heapProfileSite, such as the expression being evaluated.
+struct siteCounter {
+   void *site;
+   size_t objects;
+   size_t bytes;
+};
+
+// Starts the heap profiler, which charges every allocation to the current
+// site. Sets that site, returning the one it replaces.
+void heapProfileEnable();
+void *heapProfileSite(void *site);
+
+// The counters of every site that allocated something while profiling.
+const struct siteCounter *heapProfileSites(int *count);
+
+// Free all pointers allocated by talloc, by freeing every chunk at once.
 void tfree();
 
 // Replacement for the C function "exit", that consists of two lines: it calls
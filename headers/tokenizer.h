@@ -7,6 +7,26 @@
 // tokens.
 Value *tokenize();
 
+// Where a token or a parsed list starts and ends in the source, in lines and
+// columns counted from 1.
+struct sourceSpan {
+   int line;
+   int column;
+   int endLine;
+   int endColumn;
+};
+
+// A side table of where each parse node came from, keyed by the node itself.
+// tokenize records every token, and parse every list it builds; immediates,
+// such as integers and the empty list, and symbols, which are shared, are left
+// out.
+void recordSpan(Value *node, const struct sourceSpan *span);
+const struct sourceSpan *findSpan(Value *node);
+
+// Returns the one symbol with the given name, which tokenize uses for every
+// occurrence of the name, so that symbols can be compared by pointer.
+Value *intern(const char *name);
+
 // Displays the contents of the linked list as tokens, with type information
 void displayTokens(Value *list);
 
@@ -1,6 +1,8 @@
 #ifndef _VALUE
 #define _VALUE
 
+#include <stdint.h>
+
 typedef enum {
     INT_TYPE, DOUBLE_TYPE, STR_TYPE, CONS_TYPE, NULL_TYPE, PTR_TYPE,
     OPEN_TYPE, CLOSE_TYPE, BOOL_TYPE, SYMBOL_TYPE,
@@ -14,52 +16,134 @@ typedef enum {
     // Type below is new for primitive portion
     PRIMITIVE_TYPE,
 
+    // A variable that has been resolved to a slot of an enclosing frame
+    LOCAL_TYPE,
+
     // Type below is new for final portion
     UNSPECIFIED_TYPE
 } valueType;
 
+// A Value struct is only its payload. Its type is kept in the allocation
+// header in front of it (see talloc.h), and talloc only allocates as much of
+// the union as that type uses: 8 bytes for a number or string, 16 for a cons
+// cell or a closure, 24 for a primitive and 32 for a symbol.
 struct Value {
-    valueType type;
     union {
-        int i;
         double d;
         char *s;
         void *p;
+        // A symbol is interned, so the same one stands for every reference to
+        // its name. Its name is s, and since local variables are resolved
+        // away, it also caches where its global variable lives in the global
+        // frame, for as long as the global frame has the version it was
+        // cached at.
+        struct Symbol {
+            char *name;
+            struct Value **global;
+            unsigned long version;
+            // The number of the special form it names in the dispatch table
+            // of the analysis pass, or 0 if it names none.
+            int form;
+        } sym;
         struct ConsCell {
             struct Value *car;
             struct Value *cdr;
         } c;
         // For purposes of this project a closure is just another type of value,
         // containing everything needed to execute a user-defined function: (1)
-        // a list of formal parameter names; (2) a pointer to the function body;
-        // (3) a pointer to the environment frame in which the function was
-        // created.
+        // the analyzed lambda expression, with the number of parameters and
+        // the body (see struct Node in interpreter.c); (2) a pointer to a frame
+        // holding the free variables of the body, copied from where the
+        // function was created, or boxed if mutable.
         struct Closure {
-            struct Value *paramNames;
-            struct Value *functionCode;
+            struct Node *lambda;
             struct Frame *frame;
         } cl;
         
-        // A primitive style function; just a pointer to it, with the right
-        // signature (pf = primitive function)
-        struct Value *(*pf)(struct Value *);
+        // A primitive style function: a pointer to it, with the right
+        // signature (pf = primitive function), which takes the number of
+        // arguments and an array of them, and how many it takes, which is
+        // checked before it is called, with the error to report otherwise.
+        struct Primitive {
+            struct Value *(*pf)(int argc, struct Value **argv);
+            int minArgs;
+            int maxArgs; // -1 for any number
+            char *arityError;
+        } prim;
     };
 };
 
 typedef struct Value Value;
 
+// Integers, booleans, the empty list, void and unspecified are never
+// allocated; they are encoded directly in the bits of the Value pointer. Real
+// Value structs come from talloc and are 8-byte aligned, so their low three
+// bits are always zero. A pointer with its low bit set is a fixnum holding the
+// integer in its remaining bits. A pointer whose low three bits are 010 is a
+// constant holding its valueType in bits 3-7 and a payload (1 for #t) above.
+
+#define FIXNUM_TAG 1
+#define CONSTANT_TAG 2
+#define TAG_MASK 7
+
+#define IS_POINTER(v) ((((uintptr_t) (v)) & TAG_MASK) == 0)
+#define IS_FIXNUM(v) ((((uintptr_t) (v)) & FIXNUM_TAG) != 0)
+#define IS_CONSTANT(v) ((((uintptr_t) (v)) & TAG_MASK) == CONSTANT_TAG)
+
+#define MAKE_FIXNUM(n) ((Value *) ((((uintptr_t) (intptr_t) (n)) << 1) | FIXNUM_TAG))
+#define FIXNUM_VALUE(v) (((intptr_t) (v)) >> 1)
+#define FITS_FIXNUM(n) (FIXNUM_VALUE(MAKE_FIXNUM(n)) == (n))
+
+#define MAKE_CONSTANT(type, payload) \
+    ((Value *) ((((uintptr_t) (payload)) << 8) | (((uintptr_t) (type)) << 3) | CONSTANT_TAG))
+
+#define NULL_VALUE MAKE_CONSTANT(NULL_TYPE, 0)
+#define FALSE_VALUE MAKE_CONSTANT(BOOL_TYPE, 0)
+#define TRUE_VALUE MAKE_CONSTANT(BOOL_TYPE, 1)
+#define VOID_VALUE MAKE_CONSTANT(VOID_TYPE, 0)
+#define UNSPECIFIED_VALUE MAKE_CONSTANT(UNSPECIFIED_TYPE, 0)
+#define MAKE_BOOL(b) ((b) ? TRUE_VALUE : FALSE_VALUE)
+
+// A local variable is resolved ahead of time into the slot it has in the frame
+// that is depth parents up from the current one, and replaced with a constant
+// holding the two (see resolveVariable in interpreter.c). A mutable one is assigned
+// somewhere, so its slot may hold a box instead of its value.
+#define MAKE_LOCAL(depth, slot, mutable) MAKE_CONSTANT(LOCAL_TYPE, (((uintptr_t) (depth)) << 17) | (((uintptr_t) ((mutable) != 0)) << 16) | (slot))
+#define LOCAL_DEPTH(v) ((int) (((uintptr_t) (v)) >> 25))
+#define LOCAL_MUTABLE(v) ((int) ((((uintptr_t) (v)) >> 24) & 1))
+#define LOCAL_SLOT(v) ((int) ((((uintptr_t) (v)) >> 8) & 0xFFFF))
+
+// Everything but #f counts as true, so a truth test is one pointer compare.
+#define IS_TRUE(v) ((v) != FALSE_VALUE)
+#define IS_NULL(v) ((v) == NULL_VALUE)
+#define IS_BOOL(v) ((v) == TRUE_VALUE || (v) == FALSE_VALUE)
+#define HEAP_TYPE(v) ((valueType) ((const unsigned char *) (v))[-1])
+#define IS_CONS(v) (IS_POINTER(v) && HEAP_TYPE(v) == CONS_TYPE)
+
+// The type of any Value, whether it is a real struct or an immediate.
+static inline valueType TYPE(const Value *value) {
+    if (IS_FIXNUM(value)) {
+        return INT_TYPE;
+    }
+    if (IS_CONSTANT(value)) {
+        return (valueType) ((((uintptr_t) value) >> 3) & 31);
+    }
+    return HEAP_TYPE(value);
+}
+
+
 
-// A frame is a linked list of bindings, and a pointer to another frame.  A
-// binding is a variable name (represented as a string), and a pointer to the
-// Value it is bound to. I'm just going to put these in a flat list, with every
-// other element being a symbol, and the following element being the value. I
-// could do this via yet another data structure, but I think this will
-// ultimately take less coding. It also will require less modification of
-// existing code.
+// A frame holds the values of the variables of one call, let, let* binding or
+// letrec, in the order they were declared, and a pointer to the frame it is
+// nested in. Since every local variable is resolved to its slot before it is
+// evaluated, names aren't kept in the frame. Global variables aren't
+// resolved, so interpreter.c keeps them in a frame of their own that is used
+// as a hash table, with each symbol in the slot before its value.
 
 struct Frame {
-    struct Value *bindings;
     struct Frame *parent;
+    int size;
+    struct Value *slots[];
 };
 
 typedef struct Frame Frame;
@@ -0,0 +1,51 @@
+#include "node.h"
+
+#ifndef _VM
+#define _VM
+
+/* The instructions of the virtual machine. Each is one int, followed by the
+ * ints of its operands. Constants, symbols and nodes are operands by their
+ * index in the literals of the code they are in, and jumps by the index of
+ * the instruction they go to. The order has to match the dispatch table of
+ * runBytecode.
+ */
+
+typedef enum {
+  OP_CONSTANT,      /* literal: pushes the constant */
+  OP_LOCAL_HERE,    /* slot: pushes a local variable of the current frame */
+  OP_LOCAL,         /* depth, slot: pushes a local variable of an outer frame */
+  OP_MUTABLE_LOCAL, /* depth, slot: pushes a local variable that may be in a box */
+  OP_GLOBAL,        /* literal: pushes the value of a global variable */
+  OP_SET_LOCAL,     /* depth, slot: stores the top of the stack, replacing it with void */
+  OP_CHECK_GLOBAL,  /* literal: checks that the global variable of a set! exists */
+  OP_SET_GLOBAL,    /* literal: stores the top of the stack, replacing it with void */
+  OP_DEFINE,        /* literal: defines the top of the stack, replacing it with void */
+  OP_JUMP,          /* target */
+  OP_JUMP_IF_FALSE, /* target: pops the test */
+  OP_AND,           /* target: jumps if the top of the stack is #f, and pops it if not */
+  OP_OR,            /* target: jumps unless the top of the stack is #f, and pops it if so */
+  OP_POP,
+  OP_CHECK_LET,     /* literal, binding: checks the value of a binding of a let */
+  OP_LET,           /* literal: pops the values of the bindings of a let into its frame */
+  OP_LETREC,        /* literal: makes the frame of a letrec */
+  OP_CHECK_LETREC,  /* checks the value of a binding of a letrec */
+  OP_LETREC_SET,    /* count: pops the values of the bindings of a letrec into its frame */
+  OP_LEAVE,         /* goes back to the parent of the frame of a let or letrec */
+  OP_CLOSURE,       /* literal: pushes a closure of a lambda */
+  OP_CALL,          /* count, literal: applies a function to the arguments above it */
+  OP_TAIL_CALL,     /* count, literal: the same, in place of the current call */
+  OP_ADD,           /* literal: a call of '+' on two arguments */
+  OP_SUB,           /* literal: a call of '-' on two arguments */
+  OP_LESS,          /* literal: a call of '<' on two arguments */
+  OP_GREATER,       /* literal: a call of '>' on two arguments */
+  OP_EQUAL,         /* literal: a call of '=' on two arguments */
+  OP_RETURN,        /* returns the top of the stack */
+  OP_ERROR          /* literal: reports the error of an ERROR_NODE */
+} opcode;
+
+int arithmeticOpcode(Node *node);
+Code *compileTopLevel(Node *node);
+Value *runBytecode(Code *code);
+void printStackStats();
+
+#endif
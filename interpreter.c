@@ -17,8 +17,984 @@
 #include "headers/tokenizer.h"
 #include "headers/parser.h"
 #include "headers/interpreter.h"
+#include "headers/arithmetic.h"
+#include "headers/node.h"
+#include "headers/vm.h"
+#include "headers/jit.h"
+#include "headers/optimize.h"
+
+Frame *globalframe = NULL; /* The global variables, such as Scheme primitive & regular functions, hashed by symbol */
+static int globalCount = 0; /* How many global variables are in globalframe */
+static unsigned long globalVersion = 1; /* Changed whenever globalframe moves, so that the cells cached by symbols go stale */
+static int regionMode = 0; /* Whether each top-level expression gets its own allocation region */
+int heapProfiling = 0; /* Whether allocations are charged to the expression being evaluated */
+static int vmMode = 0; /* Whether expressions are compiled to bytecode and run by the virtual machine */
+static int jitMode = 0; /* Whether the bodies of lambdas that are called often are compiled to machine code */
+
+/* The interned symbols that eval looks for, set up by interpret */
+Value *defineSymbol;
+static Value *ifSymbol, *letSymbol, *letStarSymbol, *letRecSymbol, *quoteSymbol,
+             *lambdaSymbol, *setSymbol, *beginSymbol, *andSymbol, *orSymbol, *condSymbol, *elseSymbol;
+
+static Value *runError(Node *node, Frame *frame);
+static Value *runConstant(Node *node, Frame *frame);
+static Value *runLocalHere(Node *node, Frame *frame);
+static Value *runLocal(Node *node, Frame *frame);
+static Value *runMutableLocal(Node *node, Frame *frame);
+static Value *runGlobal(Node *node, Frame *frame);
+static Value *runIf(Node *node, Frame *frame);
+static Value *runLet(Node *node, Frame *frame);
+static Value *runLetRec(Node *node, Frame *frame);
+static Value *runSetLocal(Node *node, Frame *frame);
+static Value *runSetGlobal(Node *node, Frame *frame);
+static Value *runDefine(Node *node, Frame *frame);
+static Value *runBegin(Node *node, Frame *frame);
+static Value *runAnd(Node *node, Frame *frame);
+static Value *runOr(Node *node, Frame *frame);
+static Value *runCond(Node *node, Frame *frame);
+static Value *runCall(Node *node, Frame *frame);
+
+/* The dispatch table of special forms, indexed by the form number their
+ * symbols carry, so the analysis pass tells a special form from an
+ * application with one lookup. Entry 0 stays empty, for every other symbol. */
+struct scope;
+typedef Node *(*specialForm)(Value *expr, Value *args, struct scope *scope);
+#define SPECIAL_FORMS 16
+static specialForm specialForms[SPECIAL_FORMS];
+static int specialFormCount = 0;
+
+static void setUpSpecialForms();
+
+/* Function: setRegionMode
+ * --------------------
+ *   Turns region mode on or off. In region mode, everything allocated while
+ *   evaluating a top-level expression is reclaimed once its result is printed,
+ *   except for what escaped into the global frame through define or set!.
+ *
+ *   enabled: Whether region mode is on.
+ */
+
+void setRegionMode(int enabled) {
+  regionMode = enabled;
+}
+
+/* Function: setVmMode
+ * --------------------
+ *   Turns the virtual machine on or off. With it on, each top-level
+ *   expression is compiled to bytecode after it is analyzed, and the bytecode
+ *   is run instead of the tree of nodes.
+ *
+ *   enabled: Whether the virtual machine is on.
+ */
+
+void setVmMode(int enabled) {
+  vmMode = enabled;
+}
+
+/* Function: setJitMode
+ * --------------------
+ *   Turns the JIT on or off. With it on, the tree of nodes evaluator compiles
+ *   the body of a lambda to machine code once the lambda has been applied
+ *   JIT_THRESHOLD times. The virtual machine doesn't use it.
+ *
+ *   enabled: Whether the JIT is on.
+ */
+
+void setJitMode(int enabled) {
+  jitMode = enabled;
+}
+
+/* Function: setHeapProfile
+ * --------------------
+ *   Turns the heap profiler on, which charges everything allocated to the
+ *   innermost expression being evaluated at the time.
+ */
+
+void setHeapProfile() {
+  heapProfiling = 1;
+  heapProfileEnable();
+}
+
+/* Function: describeSite
+ * --------------------
+ *   Writes out where an allocation site is in the source and what it looks
+ *   like, such as "3:5-3:21 (cons ...)".
+ *
+ *   site: The expression charged by the heap profiler, or NULL for what was
+ *   allocated outside of any expression.
+ *   buffer: Where to write the description.
+ *   size: The size of the buffer.
+ */
+
+void describeSite(Value *site, char *buffer, size_t size) {
+  if (site == NULL) {
+    snprintf(buffer, size, "(outside any expression)");
+    return;
+  }
+  char where[64] = "?";
+  const struct sourceSpan *span = findSpan(site);
+  if (span != NULL) {
+    snprintf(where, sizeof(where), "%i:%i-%i:%i", span -> line, span -> column,
+             span -> endLine, span -> endColumn);
+  }
+  Value *first = car(site);
+  if (TYPE(first) == SYMBOL_TYPE) {
+    snprintf(buffer, size, "%s (%s ...)", where, first -> s);
+  }
+  else {
+    snprintf(buffer, size, "%s ((...) ...)", where);
+  }
+}
+
+/* Function: compareSiteBytes
+ * --------------------
+ *   Orders the counters of allocation sites by bytes allocated, most first.
+ */
+
+static int compareSiteBytes(const void *a, const void *b) {
+  const struct siteCounter *x = *(const struct siteCounter **) a;
+  const struct siteCounter *y = *(const struct siteCounter **) b;
+  return (x -> bytes < y -> bytes) - (x -> bytes > y -> bytes);
+}
+
+/* Function: compareSiteObjects
+ * --------------------
+ *   Orders the counters of allocation sites by objects allocated, most first.
+ */
+
+static int compareSiteObjects(const void *a, const void *b) {
+  const struct siteCounter *x = *(const struct siteCounter **) a;
+  const struct siteCounter *y = *(const struct siteCounter **) b;
+  return (x -> objects < y -> objects) - (x -> objects > y -> objects);
+}
+
+/* Function: printHeapProfile
+ * --------------------
+ *   Prints the allocation sites that allocated the most bytes, and those that
+ *   allocated the most objects, to stderr.
+ *
+ *   top: How many sites to print in each list.
+ */
+
+void printHeapProfile(int top) {
+  int count;
+  const struct siteCounter *sites = heapProfileSites(&count);
+  const struct siteCounter **sorted = talloc(sizeof(struct siteCounter *) * (count + 1));
+  for (int i = 0; i < count; i++) {
+    sorted[i] = &sites[i];
+  }
+  int shown = count < top ? count : top;
+  char site[128];
+
+  for (int pass = 0; pass < 2; pass++) {
+    qsort(sorted, count, sizeof(struct siteCounter *), pass == 0 ? compareSiteBytes : compareSiteObjects);
+    fprintf(stderr, "Heap profile: top %i of %i sites by %s\n", shown, count, pass == 0 ? "bytes" : "objects");
+    fprintf(stderr, "Heap profile: %12s %12s  %s\n", "bytes", "objects", "site");
+    for (int i = 0; i < shown; i++) {
+      describeSite(sorted[i] -> site, site, sizeof(site));
+      fprintf(stderr, "Heap profile: %12zu %12zu  %s\n", sorted[i] -> bytes, sorted[i] -> objects, site);
+    }
+  }
+}
+
+/* A scope of the analysis pass: the variables of one frame, in the order of
+ * their slots. Each of the first count elements of names is either a symbol,
+ * for the parameters of a lambda, or a (symbol expression) pair, for the
+ * bindings of a let, let* or letrec. The variables of a letrec are all
+ * mutable, since they are assigned after the closures of their values may
+ * have captured them.
+ *
+ * The scope right around the parameters of a lambda is its captured scope,
+ * whose variables are the free variables of the lambda, in a frame of their
+ * own that the closure holds. It starts out empty; names grows, in reverse
+ * order of slots, as they are found, and addresses holds where each of them
+ * is in the scope around the lambda, which is where the closure copies it
+ * from.
+ */
+
+struct scope {
+  Value *names;
+  int count;
+  int pairs;
+  int letrec;
+  int captured;
+  Value *addresses;
+  struct scope *parent;
+};
+
+static Node *analyze(Value *expr, struct scope *scope);
+
+/* The variables that are the target of a set! somewhere in the top-level
+ * expression being analyzed, which are the mutable ones. It errs on the side
+ * of mutable, since it doesn't tell apart variables of the same name. */
+static Value *assignedSymbols;
+
+/* Function: collectAssigned
+ * --------------------
+ *   Finds the target of every set! in an expression, leaving out quoted data.
+ *
+ *   expr: The expression.
+ *   assigned: The targets found so far.
+ *   returns: The targets found so far, followed by those in expr.
+ */
+
+Value *collectAssigned(Value *expr, Value *assigned) {
+  if (!IS_CONS(expr) || car(expr) == quoteSymbol) {
+    return assigned;
+  }
+  if (car(expr) == setSymbol && IS_CONS(cdr(expr)) && TYPE(car(cdr(expr))) == SYMBOL_TYPE) {
+    assigned = cons(car(cdr(expr)), assigned);
+  }
+  while (IS_CONS(expr)) {
+    assigned = collectAssigned(car(expr), assigned);
+    expr = cdr(expr);
+  }
+  return assigned;
+}
+
+/* Function: collectDefined
+ * --------------------
+ *   Finds the variable of every define in an expression, like
+ *   collectAssigned.
+ *
+ *   expr: The expression.
+ *   defined: The variables found so far.
+ *   returns: The variables found so far, followed by those in expr.
+ */
+
+Value *collectDefined(Value *expr, Value *defined) {
+  if (!IS_CONS(expr) || car(expr) == quoteSymbol) {
+    return defined;
+  }
+  if (car(expr) == defineSymbol && IS_CONS(cdr(expr)) && TYPE(car(cdr(expr))) == SYMBOL_TYPE) {
+    defined = cons(car(cdr(expr)), defined);
+  }
+  while (IS_CONS(expr)) {
+    defined = collectDefined(car(expr), defined);
+    expr = cdr(expr);
+  }
+  return defined;
+}
+
+/* Function: countSymbol
+ * --------------------
+ *   returns: How many times a symbol is in a list.
+ */
+
+int countSymbol(Value *list, Value *symbol) {
+  int count = 0;
+  for (Value *cur = list; IS_CONS(cur); cur = cdr(cur)) {
+    if (car(cur) == symbol) {
+      count = count + 1;
+    }
+  }
+  return count;
+}
+
+/* Function: isAssigned
+ * --------------------
+ *   Tells whether a variable is mutable, meaning the target of a set! in the
+ *   top-level expression being analyzed.
+ *
+ *   symbol: The variable.
+ *   returns: 1 if it is, 0 otherwise.
+ */
+
+static int isAssigned(Value *symbol) {
+  for (Value *cur = assignedSymbols; IS_CONS(cur); cur = cdr(cur)) {
+    if (car(cur) == symbol) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* Function: resolveVariable
+ * --------------------
+ *   Looks up a variable in the scopes it is nested in.
+ *
+ *   symbol: The variable.
+ *   scope: The innermost scope, or NULL at the top level.
+ *   returns: A local immediate with the depth and slot of the variable, or the
+ *   symbol itself if it is global.
+ */
+
+static Value *resolveVariable(Value *symbol, struct scope *scope) {
+  for (int depth = 0; scope != NULL; depth++, scope = scope -> parent) {
+    if (scope -> captured) {
+      // Nothing further out is reachable from the frame of a closure, so a
+      // free variable is added to what the closure captures, if it is local.
+      Value *cur = scope -> names;
+      Value *address = scope -> addresses;
+      for (int slot = scope -> count - 1; slot >= 0; slot--) {
+        if (car(cur) == symbol) {
+          return MAKE_LOCAL(depth, slot, LOCAL_MUTABLE(car(address)));
+        }
+        cur = cdr(cur);
+        address = cdr(address);
+      }
+      Value *outer = resolveVariable(symbol, scope -> parent);
+      if (TYPE(outer) != LOCAL_TYPE) {
+        return outer;
+      }
+      scope -> names = cons(symbol, scope -> names);
+      scope -> addresses = cons(outer, scope -> addresses);
+      scope -> count = scope -> count + 1;
+      return MAKE_LOCAL(depth, scope -> count - 1, LOCAL_MUTABLE(outer));
+    }
+
+    Value *cur = scope -> names;
+    for (int slot = 0; slot < scope -> count; slot++, cur = cdr(cur)) {
+      Value *name = car(cur);
+      if (scope -> pairs) {
+        name = IS_CONS(name) ? car(name) : NULL;
+      }
+      if (name == symbol) {
+        return MAKE_LOCAL(depth, slot, scope -> letrec || isAssigned(symbol));
+      }
+    }
+  }
+  return symbol;
+}
+
+/* Function: makeNode
+ * --------------------
+ *   Allocates a node, with room for its children, which are left for the
+ *   caller to fill in.
+ *
+ *   kind: What kind of expression it is.
+ *   run: The handler that evaluates it.
+ *   count: The number of children.
+ *   source: The expression it is analyzed from.
+ *   returns: The new node.
+ */
+
+Node *makeNode(nodeKind kind, nodeHandler run, int count, Value *source) {
+  Node *node = tallocPermanent(sizeof(Node) + count * sizeof(Node *));
+  node -> run = run;
+  node -> kind = kind;
+  node -> count = count;
+  node -> slots = 0;
+  node -> value = NULL_VALUE;
+  node -> source = source;
+  node -> text = NULL;
+  node -> code = NULL;
+  node -> calls = 0;
+  for (int i = 0; i < count; i++) {
+    node -> children[i] = NULL;
+  }
+  return node;
+}
+
+/* Function: errorNode
+ * --------------------
+ *   Makes the node of a malformed expression. The error is only reported if
+ *   the expression is evaluated, just as if it had been checked then.
+ *
+ *   source: The malformed expression.
+ *   message: The whole line to print.
+ *   returns: The new node.
+ */
+
+static Node *errorNode(Value *source, char *message) {
+  Node *node = makeNode(ERROR_NODE, runError, 0, source);
+  node -> text = message;
+  return node;
+}
+
+/* Function: constantNode
+ * --------------------
+ *   Makes the node of an expression that evaluates to itself, or of quoted
+ *   data.
+ *
+ *   value: The value it evaluates to.
+ *   source: The expression.
+ *   returns: The new node.
+ */
+
+Node *constantNode(Value *value, Value *source) {
+  Node *node = makeNode(CONSTANT_NODE, runConstant, 0, source);
+  node -> value = value;
+  return node;
+}
+
+/* Function: localNode
+ * --------------------
+ *   Makes the node of a reference to a resolved local variable, with the
+ *   handler suited to where it is.
+ *
+ *   address: The local immediate the variable was resolved to.
+ *   source: The expression.
+ *   returns: The new node.
+ */
+
+static Node *localNode(Value *address, Value *source) {
+  nodeHandler run = runLocal;
+  if (LOCAL_MUTABLE(address)) {
+    run = runMutableLocal;
+  }
+  else if (LOCAL_DEPTH(address) == 0) {
+    run = runLocalHere;
+  }
+  Node *node = makeNode(LOCAL_NODE, run, 0, source);
+  node -> value = address;
+  return node;
+}
+
+/* Function: analyzeVariable
+ * --------------------
+ *   Analyzes a reference to a variable, local or global.
+ *
+ *   symbol: The variable.
+ *   scope: The innermost scope it is in, or NULL at the top level.
+ *   returns: The node.
+ */
+
+static Node *analyzeVariable(Value *symbol, struct scope *scope) {
+  Value *address = resolveVariable(symbol, scope);
+  if (TYPE(address) == LOCAL_TYPE) {
+    return localNode(address, symbol);
+  }
+  Node *node = makeNode(GLOBAL_NODE, runGlobal, 0, symbol);
+  node -> value = symbol;
+  return node;
+}
+
+/* Function: analyzeSequence
+ * --------------------
+ *   Analyzes a list of expressions into the children of one node, such as
+ *   the body of a begin, or the function and arguments of an application.
+ *
+ *   list: The expressions.
+ *   scope: The innermost scope they are in.
+ *   source: The expression they are part of.
+ *   kind: The kind of node, for how they are combined.
+ *   run: The handler that combines them.
+ *   returns: The node.
+ */
+
+static Node *analyzeSequence(Value *list, struct scope *scope, Value *source,
+                             nodeKind kind, nodeHandler run) {
+  Node *node = makeNode(kind, run, length(list), source);
+  for (int i = 0; i < node -> count; i++) {
+    node -> children[i] = analyze(car(list), scope);
+    list = cdr(list);
+  }
+  return node;
+}
+
+/* Function: analyzeIf
+ * --------------------
+ *   Analyzes an if expression, which needs a test and two branches; anything
+ *   after them is ignored.
+ *
+ *   expr: The if expression.
+ *   args: Its arguments.
+ *   scope: The innermost scope it is in.
+ *   returns: The node.
+ */
+
+static Node *analyzeIf(Value *expr, Value *args, struct scope *scope) {
+  if (length(args) < 3) {
+    return errorNode(expr, "Evaluation error: if has fewer than 3 arguments. \n");
+  }
+  Node *node = makeNode(IF_NODE, runIf, 3, expr);
+  for (int i = 0; i < 3; i++) {
+    node -> children[i] = analyze(car(args), scope);
+    args = cdr(args);
+  }
+  return node;
+}
+
+/* Function: checkBindings
+ * --------------------
+ *   Checks the bindings of a let, let* or letrec: a list of (symbol
+ *   expression) pairs, with distinct symbols unless it is a let*.
+ *
+ *   args: The arguments of the expression.
+ *   star: Whether it is a let*, whose messages say so, and whose symbols
+ *   needn't be distinct.
+ *   returns: The message of the first thing wrong with them, or NULL.
+ */
+
+static char *checkBindings(Value *args, int star) {
+  if (!IS_CONS(args) || (!IS_NULL(car(args)) && !IS_CONS(car(args)))) {
+    return "Evaluation error: bad form in let \n";
+  }
+  for (Value *cur = car(args); !IS_NULL(cur); cur = cdr(cur)) {
+    if (!IS_CONS(cur)) {
+      return "Evaluation error: bad form in let \n";
+    }
+    Value *binding = car(cur);
+    if (IS_NULL(binding)) {
+      return star ? "Evaluation error: null binding in let*. \n"
+                  : "Evaluation error: null binding in let. \n";
+    }
+    if (!IS_CONS(binding) || !IS_CONS(cdr(binding))) {
+      return star ? "Evaluation error: bad form in let*. \n"
+                  : "Evaluation error: bad form in let \n";
+    }
+    if (TYPE(car(binding)) != SYMBOL_TYPE) {
+      return star ? "Evaluation error: left side of a let* pair doesn't have a variable. \n"
+                  : "Evaluation error: left side of a let pair doesn't have a variable. \n";
+    }
+    for (Value *previous = car(args); !star && previous != cur; previous = cdr(previous)) {
+      if (car(car(previous)) == car(binding)) {
+        return "Evaluation error: duplicate variable in let. \n";
+      }
+    }
+  }
+  return NULL;
+}
+
+/* Function: analyzeLet
+ * --------------------
+ *   Analyzes a let expression. Its values are in the scope around it, and its
+ *   body in a scope of its own with a slot for each binding.
+ *
+ *   expr: The let expression.
+ *   args: Its arguments.
+ *   scope: The innermost scope it is in.
+ *   returns: The node.
+ */
+
+static Node *analyzeLet(Value *expr, Value *args, struct scope *scope) {
+  char *error = checkBindings(args, 0);
+  if (error != NULL) {
+    return errorNode(expr, error);
+  }
+  Value *bindings = car(args);
+  int count = length(bindings);
+  struct scope inner = {bindings, count, 1, 0, 0, NULL, scope};
+  Node *node = makeNode(LET_NODE, runLet, count + 1, expr);
+  node -> slots = count;
+  node -> value = bindings;
+  node -> text = letSymbol -> s;
+  for (int i = 0; i < count; i++) {
+    node -> children[i] = analyze(car(cdr(car(bindings))), scope);
+    bindings = cdr(bindings);
+  }
+  node -> children[count] = analyzeSequence(cdr(args), &inner, expr, BEGIN_NODE, runBegin);
+  return node;
+}
+
+/* Function: analyzeLetStarBindings
+ * --------------------
+ *   Analyzes the bindings of a let* from the given one on, each of which gets
+ *   a let of its own with one slot, nested in the one before, and then its
+ *   body.
+ *
+ *   expr: The let* expression.
+ *   bindings: The rest of the bindings.
+ *   body: The body of the let*.
+ *   scope: The scope of the bindings before these.
+ *   returns: The node.
+ */
+
+static Node *analyzeLetStarBindings(Value *expr, Value *bindings, Value *body, struct scope *scope) {
+  if (IS_NULL(bindings)) {
+    return analyzeSequence(body, scope, expr, BEGIN_NODE, runBegin);
+  }
+  struct scope inner = {bindings, 1, 1, 0, 0, NULL, scope};
+  Node *node = makeNode(LET_NODE, runLet, 2, expr);
+  node -> slots = 1;
+  node -> value = bindings;
+  node -> text = letStarSymbol -> s;
+  node -> children[0] = analyze(car(cdr(car(bindings))), scope);
+  node -> children[1] = analyzeLetStarBindings(expr, cdr(bindings), body, &inner);
+  return node;
+}
+
+/* Function: analyzeLetStar
+ * --------------------
+ *   Analyzes a let* expression.
+ *
+ *   expr: The let* expression.
+ *   args: Its arguments.
+ *   scope: The innermost scope it is in.
+ *   returns: The node.
+ */
+
+static Node *analyzeLetStar(Value *expr, Value *args, struct scope *scope) {
+  char *error = checkBindings(args, 1);
+  if (error != NULL) {
+    return errorNode(expr, error);
+  }
+  return analyzeLetStarBindings(expr, car(args), cdr(args), scope);
+}
+
+/* Function: analyzeLetRec
+ * --------------------
+ *   Analyzes a letrec expression. Both its values and its body are in the
+ *   scope of its bindings.
+ *
+ *   expr: The letrec expression.
+ *   args: Its arguments.
+ *   scope: The innermost scope it is in.
+ *   returns: The node.
+ */
+
+static Node *analyzeLetRec(Value *expr, Value *args, struct scope *scope) {
+  char *error = checkBindings(args, 0);
+  if (error != NULL) {
+    return errorNode(expr, error);
+  }
+  Value *bindings = car(args);
+  int count = length(bindings);
+  struct scope inner = {bindings, count, 1, 1, 0, NULL, scope};
+  Node *node = makeNode(LETREC_NODE, runLetRec, count + 1, expr);
+  node -> slots = count;
+  for (int i = 0; i < count; i++) {
+    node -> children[i] = analyze(car(cdr(car(bindings))), &inner);
+    bindings = cdr(bindings);
+  }
+  node -> children[count] = analyzeSequence(cdr(args), &inner, expr, BEGIN_NODE, runBegin);
+  return node;
+}
+
+/* Function: analyzeQuote
+ * --------------------
+ *   Analyzes a quote expression into a constant.
+ *
+ *   expr: The quote expression.
+ *   args: Its arguments.
+ *   scope: The innermost scope it is in, which is unused.
+ *   returns: The node.
+ */
+
+static Node *analyzeQuote(Value *expr, Value *args, struct scope *scope) {
+  if (length(args) > 1) {
+    return errorNode(expr, "Evaluation error: multiple arguments to quote \n");
+  }
+  else if (TYPE(args) == NULL_TYPE) {
+    return errorNode(expr, "Evaluation error \n");
+  }
+  return constantNode(car(args), expr);
+}
+
+/* Function: analyzeDefine
+ * --------------------
+ *   Analyzes a define expression. Its value is evaluated in the global
+ *   environment wherever the define is, so it is analyzed outside of any scope.
+ *
+ *   expr: The define expression.
+ *   args: Its arguments.
+ *   scope: The innermost scope it is in, which is unused.
+ *   returns: The node.
+ */
+
+static Node *analyzeDefine(Value *expr, Value *args, struct scope *scope) {
+  if (TYPE(args) == NULL_TYPE) {
+    return errorNode(expr, "Evaluation error: no args following define. \n");
+  }
+  if (TYPE(args -> c.car) != SYMBOL_TYPE) {
+    return errorNode(expr, "Evaluation error: define must bind to a symbol. \n");
+  }
+  if (TYPE(cdr(args)) == NULL_TYPE) {
+    return errorNode(expr, "Evaluation error: no value following the symbol in define. \n");
+  }
+  Node *node = makeNode(DEFINE_NODE, runDefine, 1, expr);
+  node -> value = car(args);
+  node -> children[0] = analyze(car(cdr(args)), NULL);
+  return node;
+}
+
+/* Function: lambdaError
+ * --------------------
+ *   Checks that a lambda expression is well-formed: a list of distinct symbols
+ *   for its parameters, followed by a body.
+ *
+ *   args: The arguments of the lambda expression.
+ *   returns: The message of the first thing wrong with it, or NULL.
+ */
+
+static char *lambdaError(Value *args) {
+  if (!IS_CONS(args)) {
+    return "Evaluation error: no args following lambda. \n";
+  }
+  for (Value *cur = car(args); !IS_NULL(cur); cur = cdr(cur)) {
+    if (!IS_CONS(cur) || TYPE(car(cur)) != SYMBOL_TYPE) {
+      return "Evaluation error: formal parameters for lambda must be symbols. \n";
+    }
+    for (Value *next = cdr(cur); IS_CONS(next); next = cdr(next)) {
+      if (car(cur) == car(next)) {
+        return "Evaluation error: duplicate identifier in lambda. \n";
+      }
+    }
+  }
+  if (TYPE(cdr(args)) == NULL_TYPE) {
+    return "Evaluation error: no code in lambda following parameters. \n";
+  }
+  return NULL;
+}
+
+/* Function: analyzeLambda
+ * --------------------
+ *   Analyzes a lambda expression. Its parameters are the scope of its body,
+ *   which is nested in its captured scope rather than in the scope around it,
+ *   so every free variable the body refers to is added to what its closures
+ *   capture. Only the first expression of the body is evaluated. The node
+ *   has the body, then a local node for where each free variable is in the
+ *   scope around the lambda, in the order of the slots they get in the frame
+ *   of a closure.
+ *
+ *   expr: The lambda expression.
+ *   args: Its arguments.
+ *   scope: The innermost scope it is in.
+ *   returns: The node.
+ */
+
+static Node *analyzeLambda(Value *expr, Value *args, struct scope *scope) {
+  char *error = lambdaError(args);
+  if (error != NULL) {
+    return errorNode(expr, error);
+  }
+  struct scope captured = {makeNull(), 0, 0, 0, 1, makeNull(), scope};
+  struct scope inner = {car(args), length(car(args)), 0, 0, 0, NULL, &captured};
+  Node *body = analyze(car(cdr(args)), &inner);
+
+  Node *node = makeNode(LAMBDA_NODE, runLambda, captured.count + 1, expr);
+  node -> slots = inner.count;
+  node -> value = car(args);
+  node -> children[0] = body;
+  Value *address = captured.addresses;
+  for (int slot = captured.count - 1; slot >= 0; slot--) {
+    node -> children[slot + 1] = localNode(car(address), car(captured.names));
+    captured.names = cdr(captured.names);
+    address = cdr(address);
+  }
+  return node;
+}
+
+/* Function: analyzeSet
+ * --------------------
+ *   Analyzes a set! expression, of either a local or a global variable.
+ *
+ *   expr: The set! expression.
+ *   args: Its arguments.
+ *   scope: The innermost scope it is in.
+ *   returns: The node.
+ */
+
+static Node *analyzeSet(Value *expr, Value *args, struct scope *scope) {
+  if (length(args) < 2 || TYPE(car(args)) != SYMBOL_TYPE) {
+    return errorNode(expr, "Evaluation error: bad form in set!. \n");
+  }
+  Value *address = resolveVariable(car(args), scope);
+  Node *node;
+  if (TYPE(address) == LOCAL_TYPE) {
+    node = makeNode(SET_LOCAL_NODE, runSetLocal, 1, expr);
+  }
+  else {
+    node = makeNode(SET_GLOBAL_NODE, runSetGlobal, 1, expr);
+  }
+  node -> value = address;
+  node -> children[0] = analyze(car(cdr(args)), scope);
+  return node;
+}
+
+/* Function: analyzeBegin
+ * --------------------
+ *   Analyzes a begin expression.
+ *
+ *   expr: The begin expression.
+ *   args: Its arguments.
+ *   scope: The innermost scope it is in.
+ *   returns: The node.
+ */
+
+static Node *analyzeBegin(Value *expr, Value *args, struct scope *scope) {
+  return analyzeSequence(args, scope, expr, BEGIN_NODE, runBegin);
+}
+
+/* Function: analyzeAnd
+ * --------------------
+ *   Analyzes an and expression.
+ *
+ *   expr: The and expression.
+ *   args: Its arguments.
+ *   scope: The innermost scope it is in.
+ *   returns: The node.
+ */
+
+static Node *analyzeAnd(Value *expr, Value *args, struct scope *scope) {
+  return analyzeSequence(args, scope, expr, AND_NODE, runAnd);
+}
+
+/* Function: analyzeOr
+ * --------------------
+ *   Analyzes an or expression.
+ *
+ *   expr: The or expression.
+ *   args: Its arguments.
+ *   scope: The innermost scope it is in.
+ *   returns: The node.
+ */
+
+static Node *analyzeOr(Value *expr, Value *args, struct scope *scope) {
+  return analyzeSequence(args, scope, expr, OR_NODE, runOr);
+}
+
+/* Function: analyzeCond
+ * --------------------
+ *   Analyzes a cond expression. Each clause is a test followed by the
+ *   expression it selects, so the node has the two for each clause in turn;
+ *   the test of an else clause is the constant #t.
+ *
+ *   expr: The cond expression.
+ *   args: Its arguments.
+ *   scope: The innermost scope it is in.
+ *   returns: The node.
+ */
+
+static Node *analyzeCond(Value *expr, Value *args, struct scope *scope) {
+  for (Value *cur = args; !IS_NULL(cur); cur = cdr(cur)) {
+    if (!IS_CONS(cur) || !IS_CONS(car(cur)) || !IS_CONS(cdr(car(cur)))) {
+      return errorNode(expr, "Evaluation error: bad form in cond. \n");
+    }
+  }
+  Node *node = makeNode(COND_NODE, runCond, 2 * length(args), expr);
+  for (int i = 0; i < node -> count; i += 2) {
+    Value *test = car(car(args));
+    if (test == elseSymbol) {
+      node -> children[i] = constantNode(TRUE_VALUE, test);
+    }
+    else {
+      node -> children[i] = analyze(test, scope);
+    }
+    node -> children[i + 1] = analyze(car(cdr(car(args))), scope);
+    args = cdr(args);
+  }
+  return node;
+}
+
+/* Function: analyzeCall
+ * --------------------
+ *   Analyzes the application of a function to arguments. The node has the
+ *   function, then the arguments.
+ *
+ *   expr: The application.
+ *   scope: The innermost scope it is in.
+ *   returns: The node.
+ */
+
+static Node *analyzeCall(Value *expr, struct scope *scope) {
+  return analyzeSequence(expr, scope, expr, CALL_NODE, runCall);
+}
+
+/* Function: analyze
+ * --------------------
+ *   The analysis pass, run over each top-level expression before it is
+ *   evaluated. It turns the expression into a tree of nodes, each with the
+ *   handler that evaluates it, so the syntax is checked once rather than
+ *   every time it is evaluated; a malformed expression becomes a node that
+ *   reports the error when evaluated. Every variable of a lambda, let, let*
+ *   or letrec is resolved to the depth and slot it will have in the chain of
+ *   frames when it is evaluated, so eval never has to search for it, and the
+ *   free variables of each lambda are worked out, for its closures to
+ *   capture. Special forms are found through the dispatch table indexed by
+ *   the form number of their symbols.
+ *
+ *   expr: The expression to analyze.
+ *   scope: The innermost scope it is in, or NULL at the top level.
+ *   returns: The node.
+ */
+
+static Node *analyze(Value *expr, struct scope *scope) {
+  if (TYPE(expr) == SYMBOL_TYPE) {
+    return analyzeVariable(expr, scope);
+  }
+  if (!IS_CONS(expr)) {
+    return constantNode(expr, expr);
+  }
+  Value *first = car(expr);
+  int form = IS_POINTER(first) && HEAP_TYPE(first) == SYMBOL_TYPE ? first -> sym.form : 0;
+  if (form != 0) {
+    return specialForms[form](expr, cdr(expr), scope);
+  }
+  return analyzeCall(expr, scope);
+}
+
+/* Function: analyzeTopLevel
+ * --------------------
+ *   Runs the analysis pass over a top-level expression, and then the
+ *   optimizer, with --opt.
+ *
+ *   expr: The expression to analyze.
+ *   returns: The node.
+ */
+
+Node *analyzeTopLevel(Value *expr) {
+  assignedSymbols = collectAssigned(expr, makeNull());
+  Node *node = analyze(expr, NULL);
+  assignedSymbols = makeNull();
+  return optimizeTopLevel(expr, node);
+}
+
+/* Function: startInterpreter
+ * --------------------
+ *   Sets up what evaluating expressions needs: the dispatch table of the
+ *   analysis pass, and the global frame with each Scheme primitive function
+ *   bound in it.
+ */
+
+void startInterpreter() {
+  setUpSpecialForms();
+
+  globalframe = tallocFrame(2 * 64);
+  globalCount = 0;
+  gcAddRoot(&globalframe);
+
+  /* Bind pointers to the functions of each of the following Scheme primitive functions to global frame */
+  bind("null?", primitiveNull, 1, 1, "Evaluation error: Wrong number of args to null?. \n");
+  bind("cons", primitiveCons, 2, 2, "Evaluation error: Wrong number of args to cons. \n");
+  bind("car", primitiveCar, 1, 1, "Evaluation error: Wrong number of args to car. \n");
+  bind("cdr", primitiveCdr, 1, 1, "Evaluation error: Wrong number of args to cdr. \n");
+  bind("+", primitiveAdd, 0, -1, NULL);
+  bind("-", primitiveMinus, 1, 2, "Evaluation error: '-' can only take in two arguments. \n");
+  bind("<", primitiveLessThan, 2, 2, "Evaluation error: '<' can only take in two arguments. \n");
+  bind(">", primitiveGreaterThan, 2, 2, "Evaluation error: '>' can only take in two arguments. \n");
+  bind("=", primitiveEqual, 2, 2, "Evaluation error: '=' can only take in two arguments. \n");
+  bind("*", primitiveMultiply, 0, -1, NULL);
+  bind("/", primitiveDivide, 2, 2, "Evaluation error: '/' can only take in two arguments. \n");
+  bind("modulo", primitiveModulo, 2, 2, "Evaluation error: 'modulo' can only take in two arguments. \n");
+  bind("memory-stats", primitiveMemoryStats, 0, 0, "Evaluation error: memory-stats takes no arguments. \n");
+}
 
-Frame *globalframe = NULL; /* Bindings pointers to definitions of Scheme primitive & regular functions*/
+/* Function: printResult
+ * --------------------
+ *   Prints the result of a top-level expression.
+ *
+ *   result: The result.
+ */
+
+void printResult(Value *result) {
+  if (TYPE(result) == INT_TYPE) {
+    printf("%li \n", (long) FIXNUM_VALUE(result));
+  }
+  else if (TYPE(result) == STR_TYPE) {
+    printf("%s \n", result -> s);
+  }
+  else if (TYPE(result) == DOUBLE_TYPE) {
+    printf("%f \n", result -> d);
+  }
+  else if (TYPE(result) == BOOL_TYPE) {
+    printf("%s \n", result == TRUE_VALUE ? "#t" : "#f");
+  }
+  else if (TYPE(result) == CONS_TYPE) {
+    printTree(result);
+    printf("\n");
+  }
+  else if (TYPE(result) == VOID_TYPE){
+    printf("");
+  }
+  else if (TYPE(result) == CLOSURE_TYPE) {
+    printf("#<procedure> \n");
+  }
+  else if (TYPE(result) == NULL_TYPE) {
+    printf("() \n");
+  }
+}
 
 /* Function: interpret
  * --------------------
@@ -32,167 +1008,294 @@ Frame *globalframe = NULL; /* Bindings pointers to definitions of Scheme primiti
 void interpret(Value *tree) {
   Value *cur = tree;
   Value *result;
-  globalframe = talloc(sizeof(Frame));
-  globalframe -> bindings = makeNull();
-  globalframe -> parent = talloc(sizeof(Frame));
-  globalframe -> parent = NULL;
-
-  /* Bind pointers to the functions of each of the following Scheme primitive functions to global frame */
-  bind("null?", primitiveNull, globalframe);
-  bind("cons", primitiveCons, globalframe);
-  bind("car", primitiveCar, globalframe);
-  bind("cdr", primitiveCdr, globalframe);
-  bind("+", primitiveAdd, globalframe);
-  bind("-", primitiveMinus, globalframe);
-  bind("<", primitiveLessThan, globalframe);
-  bind(">", primitiveGreaterThan, globalframe);
-  bind("=", primitiveEqual, globalframe);
-  bind("*", primitiveMultiply, globalframe);
-  bind("/", primitiveDivide, globalframe);
-  bind("modulo", primitiveModulo, globalframe);
-
-  while (cur -> type != NULL_TYPE) {
-    Frame *frame = talloc(sizeof(Frame));
-    frame -> bindings = makeNull();
-    frame -> parent = NULL;
-    result = eval(car(cur), frame);
-
-    if (result -> type == INT_TYPE) {
-      printf("%i \n", result -> i);
-    }
-    else if (result -> type == STR_TYPE) {
-      printf("%s \n", result -> s);
-    }
-    else if (result -> type == DOUBLE_TYPE) {
-      printf("%f \n", result -> d);
-    }
-    else if (result -> type == BOOL_TYPE) {
-      printf("%s \n", result -> s);
+  startInterpreter();
+  startOptimizer(tree);
+  gcProtect(&tree);
+
+  while (TYPE(cur) != NULL_TYPE) {
+    if (regionMode) {
+      regionBegin();
+    }
+    result = eval(car(cur));
+    printResult(result);
+    if (regionMode) {
+      regionEnd();
+      // The global frame may have been grown inside the region and moved out
+      // of it.
+      globalVersion = globalVersion + 1;
     }
-    else if (result -> type == CONS_TYPE) {
-      printTree(result);
-      printf("\n");
-    }
-    else if (result -> type == VOID_TYPE){
-      printf("");
-    }
-    else if (result -> type == CLOSURE_TYPE) {
-      printf("#<procedure> \n");
+    cur = cdr(cur);
+  }
+  gcUnprotect(1);
+}
+
+/* Function: globalSlot
+ * --------------------
+ *   Finds where a global variable is in the global frame, which is an
+ *   open-addressed hash table keyed by symbol: slot 2i holds the symbol of
+ *   entry i, or the empty list if the entry is free, and slot 2i+1 its value.
+ *   Since symbols are interned, they are hashed and compared by address.
+ *
+ *   table: The global frame.
+ *   symbol: The symbol of the variable.
+ *   returns: The slot of its symbol, or of the free entry where it would go.
+ */
+
+static int globalSlot(Frame *table, Value *symbol) {
+  int mask = table -> size / 2 - 1;
+  uintptr_t h = (uintptr_t) symbol;
+  h ^= h >> 17;
+  h *= 0x9E3779B97F4A7C15ull;
+  int entry = (int) (h >> 32) & mask;
+  while (table -> slots[2 * entry] != symbol && !IS_NULL(table -> slots[2 * entry])) {
+    entry = (entry + 1) & mask;
+  }
+  return 2 * entry;
+}
+
+/* Function: defineGlobal
+ * --------------------
+ *   Binds a global variable, replacing its value if it is already bound. The
+ *   global frame is doubled whenever it gets half full, which moves every
+ *   variable, so the version of the global frame changes too. Nothing else
+ *   moves a variable once it is in the global frame.
+ *
+ *   symbol: The symbol of the variable.
+ *   value: Its new value.
+ */
+
+void defineGlobal(Value *symbol, Value *value) {
+  int capacity = globalframe -> size / 2;
+  if (2 * (globalCount + 1) > capacity) {
+    Frame *table = tallocFrame(4 * capacity);
+    for (int i = 0; i < globalframe -> size; i += 2) {
+      if (!IS_NULL(globalframe -> slots[i])) {
+        int slot = globalSlot(table, globalframe -> slots[i]);
+        table -> slots[slot] = globalframe -> slots[i];
+        table -> slots[slot + 1] = globalframe -> slots[i + 1];
+      }
     }
-    else if (result -> type == NULL_TYPE) {
-      printf("() \n");
+    globalframe = table;
+    globalVersion = globalVersion + 1;
+  }
+  int slot = globalSlot(globalframe, symbol);
+  if (IS_NULL(globalframe -> slots[slot])) {
+    globalframe -> slots[slot] = symbol;
+    globalCount = globalCount + 1;
+  }
+  globalframe -> slots[slot + 1] = value;
+  gcWriteBarrier(globalframe, value);
+}
+
+/* Function: globalCell
+ * --------------------
+ *   Finds the slot that holds the value of a global variable. It is cached in
+ *   the symbol, so the global frame is only searched the first time a symbol
+ *   is looked up, and again after the global frame moves.
+ *
+ *   symbol: The symbol of the variable.
+ *   returns: The slot of its value, or NULL if it isn't bound.
+ */
+
+Value **globalCell(Value *symbol) {
+  if (symbol -> sym.version != globalVersion) {
+    int slot = globalSlot(globalframe, symbol);
+    if (IS_NULL(globalframe -> slots[slot])) {
+      return NULL;
     }
-    cur = cdr(cur);
+    symbol -> sym.global = &globalframe -> slots[slot + 1];
+    symbol -> sym.version = globalVersion;
   }
+  return symbol -> sym.global;
+}
+
+/* Function: bind
+ * --------------------
+ *   Stores a binding that contains a pointer to the Scheme function definitions
+ *   in the global frame, along with how many arguments it takes. The count is
+ *   checked once by applyPrimitive, so the primitives themselves don't.
+ *
+ *   name: The name of some Scheme primitive function, parsed from a Scheme file.
+ *   function: Pointer to the function that will replicate the functionality
+ *   of the Scheme function stated in "name".
+ *   minArgs: The fewest arguments it takes.
+ *   maxArgs: The most arguments it takes, or -1 for any number.
+ *   arityError: The message printed when it is passed any other number.
+ */
+
+void bind(char *name, Value *(*function)(int argc, Value **argv), int minArgs, int maxArgs, char *arityError) {
+    Value *value = tallocValue(PRIMITIVE_TYPE);
+    value -> prim.pf = function;
+    value -> prim.minArgs = minArgs;
+    value -> prim.maxArgs = maxArgs;
+    value -> prim.arityError = arityError;
+
+    defineGlobal(intern(name), value);
+}
+
+/* Function: numberValue
+ * --------------------
+ *   Reads a number as a double, whether it is a fixnum or a DOUBLE_TYPE Value.
+ *
+ *   value: A fixnum or a DOUBLE_TYPE Value struct.
+ *   returns: The number as a double.
+ */
+
+static double numberValue(Value *value) {
+  if (IS_FIXNUM(value)) {
+    return (double) FIXNUM_VALUE(value);
+  }
+  return value -> d;
+}
+
+/* Function: makeDouble
+ * --------------------
+ *   Allocates a DOUBLE_TYPE Value struct. Unlike integers, doubles aren't
+ *   immediates and still live on the heap.
+ *
+ *   d: The number to store.
+ *   returns: The new DOUBLE_TYPE Value struct.
+ */
+
+static Value *makeDouble(double d) {
+  Value *result = tallocValue(DOUBLE_TYPE);
+  result -> d = d;
+  return result;
 }
 
-/* Function: bind
+/* Function: checkNumbers
  * --------------------
- *   Stores a binding that contains a pointer to the Scheme function definitions
- *   to the global frame.
+ *   Makes sure every argument is a number, and reports whether any are decimals.
  *
- *   name: The name of some Scheme primitive function, parsed from a Scheme file.
- *   function: Pointer to the function that will replicate the functionality
- *   of the Scheme function stated in "name".
- *   frame: The global frame that will store these function pointers as bindings.
+ *   argc: The number of arguments that were passed to an arithmetic primitive.
+ *   argv: The arguments.
+ *   returns: The number of DOUBLE_TYPE arguments.
+ */
+
+static int checkNumbers(int argc, Value **argv) {
+  int realFlag = 0;
+  for (int i = 0; i < argc; i++) {
+    if (TYPE(argv[i]) == DOUBLE_TYPE) {
+      realFlag += 1;
+    } else if (!IS_FIXNUM(argv[i])) {
+      printf("Evaluation error: Arguments must be a INT/DOUBLE type. \n");
+      texit(0);
+    }
+  }
+  return realFlag;
+}
+
+/* The entry points of the arithmetic and comparisons of two numbers that
+ * dispatch on the types of their arguments (see arithmetic.h), which the
+ * primitives use for a call with two arguments, and which the virtual
+ * machine and compiled C fall back on. Each operation is made from the
+ * templates below, with an entry point for a fixnum and a double in either
+ * order and one for two doubles, next to the one for two fixnums from
+ * arithmetic.h.
  */
 
-void bind(char *name, Value *(*function)(struct Value *), Frame *frame) {
-    Value *value = talloc(sizeof(Value));
-    value->type = PRIMITIVE_TYPE;
-    value->pf = function;
+enum { FIXNUM_NUMBER, DOUBLE_NUMBER, NOT_A_NUMBER };
 
-    Value *var = talloc(sizeof(Value));
-    var -> s = talloc(sizeof(char) * (strlen(name) + 1));
-    strcpy(var -> s, name);
-    var -> type = SYMBOL_TYPE;
+#define FIXNUM_PAIR (FIXNUM_NUMBER << 2 | FIXNUM_NUMBER)
+#define FIXNUM_DOUBLE_PAIR (FIXNUM_NUMBER << 2 | DOUBLE_NUMBER)
+#define DOUBLE_FIXNUM_PAIR (DOUBLE_NUMBER << 2 | FIXNUM_NUMBER)
+#define DOUBLE_PAIR (DOUBLE_NUMBER << 2 | DOUBLE_NUMBER)
 
-    Value *pair = talloc(sizeof(Value));
-    pair -> type = CONS_TYPE;
-    pair -> c.car = var;
-    pair -> c.cdr = value;
-    frame->bindings = cons(pair, frame -> bindings);
+/* Function: numberKind
+ * --------------------
+ *   returns: Whether a value is a fixnum, a double, or not a number.
+ */
+
+static inline int numberKind(Value *value) {
+  if (IS_FIXNUM(value)) {
+    return FIXNUM_NUMBER;
+  }
+  if (IS_POINTER(value) && HEAP_TYPE(value) == DOUBLE_TYPE) {
+    return DOUBLE_NUMBER;
+  }
+  return NOT_A_NUMBER;
 }
 
+/* The entry point that dispatches on the types of two arguments. The one for
+ * two fixnums returns NULL when the result overflows. */
+#define NUMBER_DISPATCH(name)                                                  \
+  Value *name(Value *a, Value *b) {                                            \
+    Value *result;                                                             \
+    switch (numberKind(a) << 2 | numberKind(b)) {                              \
+    case FIXNUM_PAIR:                                                          \
+      result = name##Fixnums(a, b);                                            \
+      return result != NULL ? result : name##Mixed(a, b);                      \
+    case DOUBLE_PAIR:                                                          \
+      return name##Doubles(a, b);                                              \
+    case FIXNUM_DOUBLE_PAIR:                                                   \
+    case DOUBLE_FIXNUM_PAIR:                                                   \
+      return name##Mixed(a, b);                                                \
+    default:                                                                   \
+      printf("Evaluation error: Arguments must be a INT/DOUBLE type. \n");     \
+      texit(0);                                                                \
+      return VOID_VALUE;                                                       \
+    }                                                                          \
+  }
+
+/* The entry points of an operation for a fixnum and a double, and for two
+ * doubles, whose results are made by the operator. */
+#define MIXED_ENTRY_POINTS(name, operator, result)                             \
+  static Value *name##Mixed(Value *a, Value *b) {                              \
+    return result(numberValue(a) operator numberValue(b));                     \
+  }                                                                            \
+  static Value *name##Doubles(Value *a, Value *b) {                            \
+    return result(a -> d operator b -> d);                                     \
+  }                                                                            \
+  NUMBER_DISPATCH(name)
+
+#define ARITHMETIC_ENTRY_POINTS(name, operator) MIXED_ENTRY_POINTS(name, operator, makeDouble)
+#define COMPARISON_ENTRY_POINTS(name, operator) MIXED_ENTRY_POINTS(name, operator, MAKE_BOOL)
+
+ARITHMETIC_ENTRY_POINTS(numberAdd, +)
+ARITHMETIC_ENTRY_POINTS(numberMinus, -)
+ARITHMETIC_ENTRY_POINTS(numberMultiply, *)
+COMPARISON_ENTRY_POINTS(numberLessThan, <)
+COMPARISON_ENTRY_POINTS(numberGreaterThan, >)
+COMPARISON_ENTRY_POINTS(numberEqual, ==)
+
 /* Function: primitiveAdd
  * --------------------
  *   This function mirrors the functionality of '+' in Scheme.
  *
- *   args: List of some number of integer or decimal arguments that would have been passed into '+'
- *   returns: If any of the arguments are decimals, return a Value struct that stores
- *   the answer as a decimal in result -> d; else return a Value struct that stores
- *   the answer as an integer in result -> i.
- */
-
-Value *primitiveAdd(Value *args) {
-   int realFlag = 0;
-   Value *result = talloc(sizeof(Value));
-   Value *cur = args;
-   while (cur -> type != NULL_TYPE) {
-     if(cur -> c.car -> type == DOUBLE_TYPE){
-       realFlag += 1;
-       cur = cdr(cur);
-     } else if(cur -> c.car -> type == INT_TYPE){
-       cur = cdr(cur);
-     } else {
-       printf("Evaluation error: Arguments must be a INT/DOUBLE type. \n");
-       texit(0);
-     }
-   }
-
-   cur = args;
-   if(realFlag == 0){
-     result -> i = 0;
+ *   argc: The number of arguments.
+ *   argv: Some number of integer or decimal arguments that would have been passed into '+'
+ *   returns: If any of the arguments are decimals, or the sum doesn't fit in
+ *   a fixnum, return a Value struct that stores the answer as a decimal in
+ *   result -> d; else return the answer as a fixnum.
+ */
 
-     while (cur -> type != NULL_TYPE) {
-       result -> i = result -> i + car(cur) -> i;
-       cur = cdr(cur);
-     }
-     result -> type = INT_TYPE;
-     return result;
-   } else {
-     result -> d = 0;
-
-     while (cur -> type != NULL_TYPE) {
-       if(car(cur) -> type == DOUBLE_TYPE){
-         result -> d = result -> d + car(cur) -> d;
-         cur = cdr(cur);
-       } else {
-         double currentArg = (double) car(cur) -> i;
-         result -> d = result -> d + currentArg;
-         cur = cdr(cur);
-       }
-     }
-    result -> type = DOUBLE_TYPE;
-    return result;
-   }
+Value *primitiveAdd(int argc, Value **argv) {
+  if (argc == 2) {
+    return numberAdd(argv[0], argv[1]);
+  }
+  Value *sum = MAKE_FIXNUM(0);
+  for (int i = 0; i < argc; i++) {
+    sum = numberAdd(sum, argv[i]);
+  }
+  return sum;
 }
 
 /* Function: primitiveCons
  * --------------------
  *   This function mirrors the functionality of 'cons' in Scheme.
  *
- *   args: List of two arguments to 'cons' together, either of which could also
+ *   argc: The number of arguments, which is two.
+ *   argv: The two arguments to 'cons' together, either of which could also
  *   be another list.
  *   returns: A pair, where the c.car is the first argument and the c.cdr is the second,
  *   which mimics the resulting list/pair when cons'ing these arguments together.
  */
 
-Value *primitiveCons(Value *args) {
-  if (args -> type == NULL_TYPE) {
-    printf("Evaluation error: No args given to cons. \n");
-    texit(0);
-  }
-  else if (length(args) != 2) {
-    printf("Evaluation error: Wrong number of args to cons. \n");
-    texit(0);
-  }
-
-  Value *pair = talloc(sizeof(Value));
-  pair -> type = CONS_TYPE;
+Value *primitiveCons(int argc, Value **argv) {
+  Value *pair = tallocValue(CONS_TYPE);
 
-  pair -> c.car = args -> c.car;
-  pair -> c.cdr = args -> c.cdr -> c.car;
+  pair -> c.car = argv[0];
+  pair -> c.cdr = argv[1];
 
   return pair;
 }
@@ -201,60 +1304,37 @@ Value *primitiveCons(Value *args) {
  * --------------------
  *   This function mirrors the functionality of 'null?' in Scheme.
  *
- *   args: List of one argument, which could be nested, to check if it is null.
- *   returns: A BOOL_TYPE Value struct that stores either "#t" or "#f" in result -> s.
+ *   argc: The number of arguments, which is one.
+ *   argv: The one argument, which could be nested, to check if it is null.
+ *   returns: Either the #t or the #f immediate.
  */
 
-Value *primitiveNull(Value *args) {
-  if (length(args) != 1) {
-    printf("Evaluation error: Wrong number of args to null?. \n");
-    texit(0);
-  }
-
-  if (length(args) == 1 && args -> c.cdr -> type != NULL_TYPE) {
-    printf("Evaluation error: Wrong number of args to null?. \n");
-    texit(0);
+Value *primitiveNull(int argc, Value **argv) {
+  Value *cur = argv[0];
+  if (!IS_CONS(cur)) {
+    return MAKE_BOOL(IS_NULL(cur));
   }
-
-  Value *result = talloc(sizeof(Value));
-  Value *cur = args;
-
-  if (cur -> type == NULL_TYPE) {
-    char *boolean = "#t";
-    result -> s = talloc(sizeof(char) * (strlen(boolean) + 1));
-    strcpy(result -> s,boolean);
-    result -> type = BOOL_TYPE;
+  while (IS_CONS(cur -> c.car)) {
+    if (!IS_NULL(cdr(cur))) {
+      return FALSE_VALUE;
+    }
+    cur = cur -> c.car;
   }
+  return MAKE_BOOL(IS_NULL(cur -> c.car));
+}
 
-  else {
-      if (cur -> type == CONS_TYPE) {
-        while (cur -> c.car -> type == CONS_TYPE) {
-          if (cur -> c.cdr -> type == NULL_TYPE) {
-            cur = cur -> c.car;
-          }
-          else {
-            char *boolean = "#f";
-            result -> s = talloc(sizeof(char) * (strlen(boolean) + 1));
-            strcpy(result -> s,boolean);
-            result -> type = BOOL_TYPE;
-            break;
-          }
-        }
-        if (cur -> c.car -> type == NULL_TYPE) {
-          char *boolean = "#t";
-          result -> s = talloc(sizeof(char) * (strlen(boolean) + 1));
-          strcpy(result -> s,boolean);
-          result -> type = BOOL_TYPE;
-        }
-        else {
-          char *boolean = "#f";
-          result -> s = talloc(sizeof(char) * (strlen(boolean) + 1));
-          strcpy(result -> s,boolean);
-          result -> type = BOOL_TYPE;
-        }
-      }
-  }
+/* Function: copyAsString
+ * --------------------
+ *   Makes a STR_TYPE Value struct sharing the text of a symbol or string, which
+ *   is how car and cdr hand back elements that aren't numbers or lists.
+ *
+ *   value: The Value struct whose text is shared.
+ *   returns: The new STR_TYPE Value struct.
+ */
 
+static Value *copyAsString(Value *value) {
+  Value *result = tallocValue(STR_TYPE);
+  result -> s = value -> s;
   return result;
 }
 
@@ -262,1450 +1342,991 @@ Value *primitiveNull(Value *args) {
  * --------------------
  *   This function mirrors the functionality of 'car' in Scheme.
  *
- *   args: List of one argument, which could be nested, to grab the car of.
+ *   argc: The number of arguments, which is one.
+ *   argv: The one argument, which could be nested, to grab the car of.
  *   returns: A Value struct whose type and result depends on what is found in the car.
  */
 
-Value *primitiveCar(Value *args) {
-  if (length(args) != 1) {
+Value *primitiveCar(int argc, Value **argv) {
+  if (!IS_CONS(argv[0])) {
     printf("Evaluation error: Wrong number of args to car. \n");
     texit(0);
   }
 
-  if (args -> type == CONS_TYPE) {
-    if (args -> c.car -> type != CONS_TYPE) {
-      printf("Evaluation error: Wrong number of args to car. \n");
-      texit(0);
-    }
-  }
-
-  Value *result = talloc(sizeof(Value));
-
-  if (args -> c.car -> type == CONS_TYPE) {
-
-    if (args -> c.car -> c.car -> type == CONS_TYPE) {
-      result = args -> c.car -> c.car;
-    }
-
-    else if (args -> c.car -> c.car -> type == INT_TYPE) {
-      result -> type = INT_TYPE;
-      result -> i = args -> c.car -> c.car -> i;
-    }
-
-    else if (args -> c.car -> c.car -> type == DOUBLE_TYPE) {
-      result -> type = DOUBLE_TYPE;
-      result -> d = args -> c.car -> c.car -> d;
-    }
-
-    else if (args -> c.car -> c.car -> type == NULL_TYPE) {
-      result = makeNull();
-    }
-
-    else {
-      result -> type = STR_TYPE;
-      result -> s = args -> c.car -> c.car -> s;
-    }
-  }
-
-  else if (args -> c.car -> type == INT_TYPE) {
-    result -> type = INT_TYPE;
-    result -> i = args -> c.car -> i;
-  }
-
-  else if (args -> c.car -> type == DOUBLE_TYPE) {
-    result -> type = DOUBLE_TYPE;
-    result -> d = args -> c.car -> d;
-  }
-
-  else if (args -> c.car -> type == NULL_TYPE) {
-    result = makeNull();
-  }
-
-  else {
-    result -> type = STR_TYPE;
-    result -> s = args -> c.car -> s;
+  Value *element = argv[0] -> c.car;
+  if (!IS_POINTER(element) || TYPE(element) == CONS_TYPE || TYPE(element) == DOUBLE_TYPE) {
+    return element;
   }
-  return result;
+  return copyAsString(element);
 }
 
 /* Function: primitiveCdr
  * --------------------
  *   This function mirrors the functionality of 'cdr' in Scheme.
  *
- *   args: List of one argument, which could be nested, to grab the cdr of.
+ *   argc: The number of arguments, which is one.
+ *   argv: The one argument, which could be nested, to grab the cdr of.
  *   returns: A Value struct whose type and result depends on what is found in the cdr.
  */
 
-Value *primitiveCdr(Value *args) {
-  if (length(args) != 1) {
-    printf("Evaluation error: Wrong number of args to cdr. \n");
-    texit(0);
-  }
-
-  Value *pair = talloc(sizeof(Value));
-
-  if (args -> c.car -> type == CONS_TYPE) {
-
-    if (args -> c.car -> c.cdr -> type == CONS_TYPE) {
-      pair -> type = CONS_TYPE;
-      pair -> c.car = talloc(sizeof(Value));
-      pair -> c.car = args -> c.car -> c.cdr -> c.car;
-      pair -> c.cdr = args -> c.car -> c.cdr -> c.cdr;
-    }
-
-    else if (args -> c.car -> c.cdr -> type == INT_TYPE) {
-      pair -> type = INT_TYPE;
-      pair -> i = args -> c.car -> c.cdr -> i;
-    }
-
-    else if (args -> c.car -> c.cdr -> type == DOUBLE_TYPE) {
-      pair -> type = DOUBLE_TYPE;
-      pair -> d = args -> c.car -> c.cdr -> d;
-    }
-
-    else if (args -> c.car -> c.cdr -> type == NULL_TYPE) {
-      pair -> type = NULL_TYPE;
-    }
-
-    else{
-      pair -> type = STR_TYPE;
-      pair -> s = args -> c.car -> c.cdr -> s;
-    }
-  }
-
-  else if (args -> c.car -> type == INT_TYPE) {
-    pair -> type = INT_TYPE;
-    pair -> i = args -> c.cdr -> i;
-  }
-
-  else if (args -> c.car -> type == DOUBLE_TYPE) {
-    pair -> type = DOUBLE_TYPE;
-    pair -> d = args -> c.cdr -> d;
+Value *primitiveCdr(int argc, Value **argv) {
+  if (IS_NULL(argv[0])) {
+    return makeNull();
   }
-
-  else if (args -> c.car -> type == NULL_TYPE) {
-    pair -> type = NULL_TYPE;
+  if (!IS_CONS(argv[0])) {
+    printf("Evaluation error: cdr of a non-pair. \n");
+    texit(0);
   }
 
-  else {
-    pair -> type = STR_TYPE;
-    pair -> s = args -> c.cdr -> s;
+  Value *rest = cdr(argv[0]);
+  if (!IS_POINTER(rest) || TYPE(rest) == CONS_TYPE || TYPE(rest) == DOUBLE_TYPE) {
+    return rest;
   }
-
-  return pair;
+  return copyAsString(rest);
 }
 
 /* Function: primitiveMinus
  * --------------------
  *   This function mirrors the functionality of '-' in Scheme.
  *
- *   args: List of some number of integer or decimal arguments that would have been passed into '-'.
- *   returns: If any of the arguments are decimal, return a Value struct that stores
- *   the answer as a decimal in result -> d; else return a Value struct that stores
- *   the answer as an integer in result -> i.
+ *   argc: The number of arguments, one or two.
+ *   argv: The integer or decimal arguments that would have been passed into '-'.
+ *   returns: If any of the arguments are decimal, or the difference doesn't
+ *   fit in a fixnum, return a Value struct that stores the answer as a
+ *   decimal in result -> d; else return the answer as a fixnum. One argument
+ *   is negated.
  */
 
-Value *primitiveMinus(Value *args) {
-   if(length(args) > 2){
-     printf("Evaluation error: '-' can only take in two arguments. \n");
-     texit(0);
-   }
-
-   int realFlag = 0;
-   Value *result = talloc(sizeof(Value));
-   Value *cur = args;
-   while (cur -> type != NULL_TYPE) {
-     if(cur -> c.car -> type == DOUBLE_TYPE){
-       realFlag += 1;
-       cur = cdr(cur);
-     } else if(cur -> c.car -> type == INT_TYPE){
-       cur = cdr(cur);
-     } else {
-       printf("Evaluation error: Arguments must be a INT/DOUBLE type. \n");
-       texit(0);
-     }
-   }
-
-   cur = args;
-   if(realFlag == 0){
-     result -> i = (car(cur) -> i) - (car(cdr(cur)) -> i);
-
-     result -> type = INT_TYPE;
-     return result;
-   }
-   else {
-     result -> d = 0;
-
-     if(car(cur) -> type == DOUBLE_TYPE){
-       if(car(cdr(cur)) -> type == DOUBLE_TYPE) {
-         result -> d = (car(cur) -> d) - (car(cdr(cur)) -> d);
-       } else{
-         double currentArg = (double) car(cdr(cur)) -> i;
-         result -> d = (car(cur) -> d) - currentArg;
-       }
-      } else {
-        double currentArg = (double) car(cur) -> i;
-
-        result -> d = currentArg - (car(cdr(cur)) -> d);
-      }
-
-    result -> type = DOUBLE_TYPE;
-    return result;
+Value *primitiveMinus(int argc, Value **argv) {
+   if (argc == 2) {
+     return numberMinus(argv[0], argv[1]);
    }
+   return numberMinus(MAKE_FIXNUM(0), argv[0]);
 }
 
 /* Function: primitiveLessThan
  * --------------------
  *   This function mirrors the functionality of '<' in Scheme.
  *
- *   args: List of two integers to compare.
- *   returns: A BOOL_TYPE Value struct that stores either "#t" or "#f" in result -> s.
+ *   argc: The number of arguments, which is two.
+ *   argv: The two numbers to compare.
+ *   returns: Either the #t or the #f immediate.
  */
 
-Value *primitiveLessThan(Value *args) {
-   Value *cur = args;
-   Value *result = talloc(sizeof(Value));
-   if(length(args) > 2){
-     printf("Evaluation error: '<' can only take in two arguments. \n");
-     texit(0);
-   }
-   if (car(cur) -> i < cdr(cur) -> c.car -> i) {
-     char *boolean = "#t";
-     result -> s = talloc(sizeof(char) * (strlen(boolean) + 1));
-     strcpy(result -> s,boolean);
-     result -> type = BOOL_TYPE;
-   }
-   else {
-     char *boolean = "#f";
-     result -> s = talloc(sizeof(char) * (strlen(boolean) + 1));
-     strcpy(result -> s,boolean);
-     result -> type = BOOL_TYPE;
-   }
-   return result;
+Value *primitiveLessThan(int argc, Value **argv) {
+   return numberLessThan(argv[0], argv[1]);
 }
 
 /* Function: primitiveGreaterThan
  * --------------------
  *   This function mirrors the functionality of '>' in Scheme.
  *
- *   args: List of two integers to compare.
- *   returns: A BOOL_TYPE Value struct that stores either "#t" or "#f" in result -> s.
+ *   argc: The number of arguments, which is two.
+ *   argv: The two numbers to compare.
+ *   returns: Either the #t or the #f immediate.
  */
 
-Value *primitiveGreaterThan(Value *args) {
-   Value *cur = args;
-   Value *result = talloc(sizeof(Value));
-   if(length(args) > 2){
-     printf("Evaluation error: '>' can only take in two arguments. \n");
-     texit(0);
-   }
-
-   if (car(cur) -> i > cdr(cur) -> c.car -> i) {
-     char *boolean = "#t";
-     result -> s = talloc(sizeof(char) * (strlen(boolean) + 1));
-     strcpy(result -> s,boolean);
-     result -> type = BOOL_TYPE;
-   }
-   else {
-     char *boolean = "#f";
-     result -> s = talloc(sizeof(char) * (strlen(boolean) + 1));
-     strcpy(result -> s,boolean);
-     result -> type = BOOL_TYPE;
-   }
-   return result;
+Value *primitiveGreaterThan(int argc, Value **argv) {
+   return numberGreaterThan(argv[0], argv[1]);
 }
 
 /* Function: primitiveEqual
  * --------------------
  *   This function mirrors the functionality of '=' in Scheme.
  *
- *   args: List of two numbers, either decimals or integers, to compare.
- *   returns: A BOOL_TYPE Value struct that stores either "#t" or "#f" in result -> s.
+ *   argc: The number of arguments, which is two.
+ *   argv: The two numbers, either decimals or integers, to compare.
+ *   returns: Either the #t or the #f immediate.
  */
 
-Value *primitiveEqual(Value *args) {
-  if (length(args) > 2) {
-     printf("Evaluation error: '=' can only take in two arguments. \n");
-     texit(0);
-   }
-
-   int realFlag = 0;
-   Value *result = talloc(sizeof(Value));
-   Value *cur = args;
-   while (cur -> type != NULL_TYPE) {
-     if (cur -> c.car -> type == DOUBLE_TYPE) {
-       realFlag += 1;
-       cur = cdr(cur);
-     } else if (cur -> c.car -> type == INT_TYPE) {
-       cur = cdr(cur);
-     } else {
-       printf("Evaluation error: Arguments must be a INT/DOUBLE type. \n");
-       texit(0);
-     }
-   }
-
-   cur = args;
-
-   if (realFlag == 0) {
-     int param1 = car(cur) -> i;
-     int param2 = car(cdr(cur)) -> i;
-
-     if (param1 == param2) {
-       char *boolean = "#t";
-       result -> s = talloc(sizeof(char) * (strlen(boolean) + 1));
-       strcpy(result -> s,boolean);
-       result -> type = BOOL_TYPE;
-     } else {
-       char *boolean = "#f";
-       result -> s = talloc(sizeof(char) * (strlen(boolean) + 1));
-       strcpy(result -> s,boolean);
-       result -> type = BOOL_TYPE;
-     }
-   }
-
-   else {
-     double param1 = 0;
-     double param2 = 0;
-
-     if (car(cur) -> type == DOUBLE_TYPE) {
-       param1 = car(cur) -> d;
-
-       if(car(cdr(cur)) -> type == DOUBLE_TYPE) {
-         param2 = car(cdr(cur)) -> d;
-       } else{
-         param2 = (double) car(cdr(cur)) -> i;
-       }
-
-      } else {
-        param1 = (double) car(cur) -> i;
-        param2 = car(cdr(cur)) -> d;
-      }
-
-      if(param1 == param2){
-        char *boolean = "#t";
-        result -> s = talloc(sizeof(char) * (strlen(boolean) + 1));
-        strcpy(result -> s,boolean);
-        result -> type = BOOL_TYPE;
-      }
-      else {
-        char *boolean = "#f";
-        result -> s = talloc(sizeof(char) * (strlen(boolean) + 1));
-        strcpy(result -> s,boolean);
-        result -> type = BOOL_TYPE;
-      }
-   }
-
-   return result;
+Value *primitiveEqual(int argc, Value **argv) {
+   return numberEqual(argv[0], argv[1]);
 }
 
 /* Function: primitiveMultiply
  * --------------------
  *   This function mirrors the functionality of '*' (the multiply operator) in Scheme.
  *
- *   args: List of some number of integer or decimal arguments that would have been passed into '*'.
- *   returns: If any of the arguments are decimals, return a Value struct that stores
- *   the answer as a decimal in result -> d; else return a Value struct that stores
- *   the answer as an integer in result -> i.
+ *   argc: The number of arguments.
+ *   argv: Some number of integer or decimal arguments that would have been passed into '*'.
+ *   returns: If any of the arguments are decimals, or the product doesn't
+ *   fit in a fixnum, return a Value struct that stores the answer as a
+ *   decimal in result -> d; else return the answer as a fixnum.
  */
 
 //This method is a primitive method that functions as the 'multiply' method in scheme, where it multiples two ints/double that is passed as parameters to the 'multiply' fuction. If the parameters are neither int/double type, it will be an error.
-Value *primitiveMultiply(Value *args) {
-   int realFlag = 0;
-   Value *result = talloc(sizeof(Value));
-   Value *cur = args;
-   while (cur -> type != NULL_TYPE) {
-     if(cur -> c.car -> type == DOUBLE_TYPE){
-       realFlag += 1;
-       cur = cdr(cur);
-     } else if(cur -> c.car -> type == INT_TYPE){
-       cur = cdr(cur);
-     } else {
-       printf("Evaluation error: Arguments must be an INT/DOUBLE type. \n");
-       texit(0);
-     }
-   }
-
-   cur = args;
-
-   if (realFlag == 0) {
-     result -> i = 1;
-
-     while (cur -> type != NULL_TYPE) {
-       result -> i = result -> i * car(cur) -> i;
-       cur = cdr(cur);
-     }
-     result -> type = INT_TYPE;
-     return result;
+Value *primitiveMultiply(int argc, Value **argv) {
+   if (argc == 2) {
+     return numberMultiply(argv[0], argv[1]);
    }
-
-   else {
-     result -> d = 1;
-
-     while (cur -> type != NULL_TYPE) {
-       if(car(cur) -> type == DOUBLE_TYPE) {
-         result -> d = result -> d * car(cur) -> d;
-         cur = cdr(cur);
-       } else {
-         double currentArg = (double) car(cur) -> i;
-         result -> d = result -> d * currentArg;
-         cur = cdr(cur);
-       }
-     }
-    result -> type = DOUBLE_TYPE;
-    return result;
+   Value *product = MAKE_FIXNUM(1);
+   for (int i = 0; i < argc; i++) {
+     product = numberMultiply(product, argv[i]);
    }
+   return product;
 }
 
 /* Function: primitiveDivide
  * --------------------
  *   This function mirrors the functionality of '/' in Scheme.
  *
- *   args: List of some number of integer or decimal arguments that would have been passed into '/'.
- *   returns: If any of the arguments are decimals, return a Value struct that stores
- *   the answer as a decimal in result -> d; else return a Value struct that stores
- *   the answer as an integer in result -> i.
+ *   argc: The number of arguments, which is two.
+ *   argv: The two integer or decimal arguments that would have been passed into '/'.
+ *   returns: If any of the arguments are decimals, or the division isn't exact,
+ *   return a Value struct that stores the answer as a decimal in result -> d;
+ *   else return the answer as a fixnum. Dividing by the integer 0 is an
+ *   evaluation error.
  */
 
-Value *primitiveDivide(Value *args) {
-   if (length(args) > 2) {
-     printf("Evaluation error: '/' can only take in two arguments. \n");
-     texit(0);
-   }
+Value *primitiveDivide(int argc, Value **argv) {
+   int realFlag = checkNumbers(argc, argv);
 
-   int realFlag = 0;
-   Value *result = talloc(sizeof(Value));
-   Value *cur = args;
-
-   while (cur -> type != NULL_TYPE) {
-     if (cur -> c.car -> type == DOUBLE_TYPE) {
-       realFlag += 1;
-       cur = cdr(cur);
-     } else if (cur -> c.car -> type == INT_TYPE) {
-       cur = cdr(cur);
-     } else {
-       printf("Evaluation error: Arguments must be a INT/DOUBLE type. \n");
-       texit(0);
-     }
+   if (argv[1] == MAKE_FIXNUM(0)) {
+     printf("Evaluation error: Division by zero. \n");
+     texit(0);
    }
 
-   cur = args;
-
    if (realFlag == 0) {
-     int param1 = car(cur) -> i;
-     int param2 = car(cdr(cur)) -> i;
+     intptr_t param1 = FIXNUM_VALUE(argv[0]);
+     intptr_t param2 = FIXNUM_VALUE(argv[1]);
 
-      if (param1 % param2 == 0) {
-        result -> i = param1 / param2;
-        result -> type = INT_TYPE;
-        return result;
+      // The quotient of the smallest fixnum and -1 is one past the largest,
+      // which FITS_FIXNUM turns into a decimal.
+      if (param1 % param2 == 0 && FITS_FIXNUM(param1 / param2)) {
+        return MAKE_FIXNUM(param1 / param2);
       } else {
-        result -> d = (double) param1 / (double) param2;
-        result -> type = DOUBLE_TYPE;
-        return result;
+        return makeDouble((double) param1 / (double) param2);
       }
    }
 
-   else {
-     double param1 = 0;
-     double param2 = 0;
-
-     if (car(cur) -> type == DOUBLE_TYPE) {
-       param1 = car(cur) -> d;
-       if (car(cdr(cur)) -> type == DOUBLE_TYPE) {
-         param2 = car(cdr(cur)) -> d;
-       }
-       param2 = (double) car(cdr(cur)) -> i;
-     }
-
-     result -> d = param1 / param2;
-     result -> type = DOUBLE_TYPE;
-     return result;
-   }
+   return makeDouble(numberValue(argv[0]) / numberValue(argv[1]));
 }
 
 /* Function: primitiveModulo
  * --------------------
  *   This function mirrors the functionality of 'modulo' in Scheme.
  *
- *   args: List of two integers to take the modulo of.
- *   returns: A INT_TYPE Value struct that stores the integer result in result -> i.
+ *   argc: The number of arguments, which is two.
+ *   argv: The two integers to take the modulo of.
+ *   returns: The integer result as a fixnum. A divisor of 0 is an evaluation
+ *   error.
  */
 
-Value *primitiveModulo(Value *args) {
-   if (length(args) > 2) {
-     printf("Evaluation error: 'modulo' can only take in two arguments. \n");
-     texit(0);
-   }
-
-   Value *result = talloc(sizeof(Value));
-   Value *cur = args;
-
-   while (cur -> type != NULL_TYPE) {
-     if(cur -> c.car -> type != INT_TYPE){
+Value *primitiveModulo(int argc, Value **argv) {
+   for (int i = 0; i < argc; i++) {
+     if (!IS_FIXNUM(argv[i])) {
        printf("Evaluation error: Arguments must be a INT type. \n");
        texit(0);
      }
-
-     cur = cdr(cur);
    }
 
-   cur = args;
+   intptr_t param1 = FIXNUM_VALUE(argv[0]);
+   intptr_t param2 = FIXNUM_VALUE(argv[1]);
 
-   int param1 = car(cur) -> i;
-   int param2 = car(cdr(cur)) -> i;
+   if (param2 == 0) {
+     printf("Evaluation error: Modulo by zero. \n");
+     texit(0);
+   }
 
-   result -> i = param1 % param2;
-   result -> type = INT_TYPE;
-   return result;
+   // Fixnums are 63-bit, so param1 is never INTPTR_MIN and the remainder
+   // of dividing it by -1 can't trap.
+   return MAKE_FIXNUM(param1 % param2);
 }
 
-/* Function: evalIf
+/* Function: primitiveMemoryStats
  * --------------------
- *   This function mirrors the functionality of 'if' in Scheme. It evaluates the
- *   arguments of the 'if' expression, and returns either '#t' or '#f'.
+ *   Reports how memory is being used, as kept track of by talloc. The counters
+ *   are read before the result is built, so they don't include it.
  *
- *   args: List of arguments to evaluate.
- *   returns: A BOOL_TYPE Value struct that stores either "#t" or "#f" in result -> s.
+ *   argc: The number of arguments, which is zero.
+ *   argv: No arguments.
+ *   returns: A list whose first two elements are (live-bytes n) and
+ *   (peak-bytes n), followed by (name live live-bytes allocated allocated-bytes)
+ *   for every sort of object that was ever allocated.
  */
 
-Value *evalIf(Value *args, Frame *frame) {
-  if (length(args) < 3) {
-    printf("Evaluation error: if has fewer than 3 arguments. \n");
-    texit(0);
-  }
-  Value *result_test;
-  Value *result_trueExpr = makeNull();
-  Value *result_falseExpr= makeNull();
-  result_test = eval(car(args), frame);
-  if (!strcmp(result_test -> s, "#t")) {
-    result_trueExpr = eval(cdr(args) -> c.car, frame);
+Value *primitiveMemoryStats(int argc, Value **argv) {
+  struct memoryCounter counters[MEMORY_COUNTERS];
+  memcpy(counters, memoryCounters(), sizeof(counters));
+  size_t liveBytes = memoryLiveBytes();
+  size_t peakBytes = memoryPeakBytes();
+
+  Value *result = makeNull();
+  for (int i = MEMORY_COUNTERS - 1; i >= 0; i--) {
+    if (counters[i].allocatedObjects == 0 && counters[i].liveObjects == 0) {
+      continue;
+    }
+    Value *entry = cons(MAKE_FIXNUM(counters[i].allocatedBytes), makeNull());
+    entry = cons(MAKE_FIXNUM(counters[i].allocatedObjects), entry);
+    entry = cons(MAKE_FIXNUM(counters[i].liveBytes), entry);
+    entry = cons(MAKE_FIXNUM(counters[i].liveObjects), entry);
+    entry = cons(intern(memoryCounterName(i)), entry);
+    result = cons(entry, result);
   }
-  else if (!strcmp(result_test -> s, "#f")) {
-    result_falseExpr = eval(cdr(args) -> c.cdr -> c.car, frame);
+  result = cons(cons(intern("peak-bytes"), cons(MAKE_FIXNUM(peakBytes), makeNull())), result);
+  result = cons(cons(intern("live-bytes"), cons(MAKE_FIXNUM(liveBytes), makeNull())), result);
+  return result;
+}
+
+/* Function: growBuffer
+ * --------------------
+ *   Makes sure a buffer of the compiler or the virtual machine has room for
+ *   some more elements, doubling it if it doesn't.
+ *
+ *   buffer: The buffer, which may be NULL.
+ *   capacity: How many elements fit in it, which is updated.
+ *   needed: How many elements have to fit.
+ *   size: The size of an element.
+ *   returns: The buffer, which may have moved.
+ */
+
+void *growBuffer(void *buffer, int *capacity, int needed, size_t size) {
+  if (needed <= *capacity) {
+    return buffer;
   }
-  if (result_trueExpr -> type != NULL_TYPE) {
-    return result_trueExpr;
+  int newCapacity = *capacity == 0 ? 64 : *capacity;
+  while (newCapacity < needed) {
+    newCapacity = 2 * newCapacity;
   }
-  else {
-    return result_falseExpr;
+  buffer = realloc(buffer, newCapacity * size);
+  if (buffer == NULL) {
+    printf("Memory error: out of memory. \n");
+    texit(1);
   }
+  *capacity = newCapacity;
+  return buffer;
 }
 
-/* Function: evalLet
+/* Function: frameAt
  * --------------------
- *   This function mirrors the functionality of a "let" expression in Scheme. It
- *   does so by creating a new frame whose parent is the frame passed in, then
- *   stores each of the arguments of the statement as bindings within the new frame. They
- *   are bound to the their own corresponding, evaluated expressions. Lastly, it
- *   evaluates the body of the let expression in this new frame.
+ *   Finds the frame that a resolved local variable is in.
  *
- *   args: The Value struct arguments of the let expression
- *   frame: The current Frame struct of the interpreter
- *   returns: Result of evaluating the body of the let expression in the new frame.
+ *   frame: The current Frame struct of the interpreter.
+ *   depth: How many parents up from the current frame it is.
+ *   returns: The frame.
  */
 
-Value *evalLet(Value *args, Frame *frame) {
-  if (car(args) -> type != NULL_TYPE && car(args) -> type != CONS_TYPE) {
-    printf("Evaluation error: bad form in let \n");
-    texit(0);
+Frame *frameAt(Frame *frame, int depth) {
+  while (depth > 0) {
+    frame = frame -> parent;
+    depth = depth - 1;
   }
+  return frame;
+}
 
-  Value *cur = args;
-  Frame *newframe = talloc(sizeof(Frame));
-  newframe -> parent = frame;
-  Value *bindings = makeNull();
-  newframe -> bindings = bindings;
-  Value *result;
+/* Function: runError
+ * --------------------
+ *   Reports the error of a malformed expression, found when it was analyzed.
+ *
+ *   node: An ERROR_NODE.
+ *   frame: The current Frame struct of the interpreter.
+ *   returns: Nothing, since it exits.
+ */
 
-  Value *expressions = car(cur);
-  while (expressions -> type != NULL_TYPE) {
-    Value *var = talloc(sizeof(Value));
-    if (expressions -> c.car -> type == NULL_TYPE) {
-      printf("Evaluation error: null binding in let. \n");
-      texit(0);
-    }
+static Value *runError(Node *node, Frame *frame) {
+  printf("%s", node -> text);
+  texit(0);
+  return VOID_VALUE;
+}
 
-    else if (expressions -> c.car -> type != NULL_TYPE && expressions -> c.car -> type != CONS_TYPE) {
-      printf("Evaluation error: bad form in let \n");
-      texit(0);
-    }
+/* Function: runConstant
+ * --------------------
+ *   Evaluates a constant, such as a number or quoted data, to itself.
+ *
+ *   node: A CONSTANT_NODE.
+ *   frame: The current Frame struct of the interpreter.
+ *   returns: The constant.
+ */
 
-    else if (expressions -> c.car -> type ==  CONS_TYPE) {
-      if (expressions -> c.car -> c.car -> type != SYMBOL_TYPE) {
-        printf("Evaluation error: left side of a let pair doesn't have a variable. \n");
-        texit(0);
-      }
-    }
+static Value *runConstant(Node *node, Frame *frame) {
+  return node -> value;
+}
 
-    char *text = expressions -> c.car -> c.car -> s;
+/* Function: runLocalHere
+ * --------------------
+ *   Looks up a local variable of the current frame that is never assigned.
+ *
+ *   node: A LOCAL_NODE.
+ *   frame: The current Frame struct of the interpreter.
+ *   returns: The value of the variable.
+ */
 
-    if (newframe -> bindings -> type != NULL_TYPE) {
-      Value *curbinding = newframe -> bindings;
-      Value *checkduplicate = makeNull();
-      while (curbinding -> type != NULL_TYPE) {
-        if (!strcmp(curbinding->c.car->c.car -> s, expressions -> c.car -> c.car -> s)) {
-          checkduplicate = curbinding->c.car->c.cdr;
-          break;
-        }
-        else {
-          curbinding = curbinding -> c.cdr;
-        }
-      }
-      if (checkduplicate -> type != NULL_TYPE) {
-        printf("Evaluation error: duplicate variable in let. \n");
-        texit(0);
-      }
-    }
+static Value *runLocalHere(Node *node, Frame *frame) {
+  return frame -> slots[LOCAL_SLOT(node -> value)];
+}
 
-    var -> s = talloc(sizeof(char) * (strlen(text) + 1));
-    strcpy(var -> s,text);
-    var -> type = STR_TYPE;
-    Value *val = talloc(sizeof(Value));
-    val = eval(expressions -> c.car -> c.cdr -> c.car, frame);
-    if (val -> type == CLOSURE_TYPE || val -> type == UNSPECIFIED_TYPE) {
-      printf("Evaluation error: Unbound variable %s in let. \n", var -> s);
-      texit(0);
-    }
+/* Function: runLocal
+ * --------------------
+ *   Looks up a local variable that is never assigned, by following the
+ *   parents of the current frame to the frame it is in.
+ *
+ *   node: A LOCAL_NODE.
+ *   frame: The current Frame struct of the interpreter.
+ *   returns: The value of the variable.
+ */
 
-    Value *pair = talloc(sizeof(Value));
-    pair -> type = CONS_TYPE;
-    pair -> c.car = var;
-    pair -> c.cdr = val;
-    bindings = cons(pair, bindings);
-    newframe -> bindings = bindings;
+static Value *runLocal(Node *node, Frame *frame) {
+  return frameAt(frame, LOCAL_DEPTH(node -> value)) -> slots[LOCAL_SLOT(node -> value)];
+}
 
-    expressions = cdr(expressions);
-  }
+/* Function: runMutableLocal
+ * --------------------
+ *   Looks up a local variable that is assigned somewhere, and so may have
+ *   been moved into a box.
+ *
+ *   node: A LOCAL_NODE.
+ *   frame: The current Frame struct of the interpreter.
+ *   returns: The value of the variable.
+ */
 
-  Value *curbody = cdr(args);
-  while (curbody -> type != NULL_TYPE) {
-    result = eval(car(curbody), newframe);
-    curbody = cdr(curbody);
+static Value *runMutableLocal(Node *node, Frame *frame) {
+  Value *result = frameAt(frame, LOCAL_DEPTH(node -> value)) -> slots[LOCAL_SLOT(node -> value)];
+  if (IS_BOX(result)) {
+    result = ((Frame *) result) -> slots[0];
   }
   return result;
 }
 
-/* Function: evalLetStar
+/* Function: runGlobal
  * --------------------
- *   This function mirrors the functionality of a "let*" expression in Scheme. It
- *   does so by creating a new Frame struct for every variable within the expression, with
- *   their parent's linking to the previously created frame; the first frame that
- *   is created has the frame that was passed into the function become its parent.
- *   Each new frame created has only one binding, the variable it holds bound to
- *   its corresponding, evaluated expression. Lastly, it evaluates the body of
- *   the let* expression by starting from the last frame created, and bubbling up
- *   the chain of frames until it can find the correct variable to evaluate.
+ *   This function looks up a global variable in the global frame, through the
+ *   cell cached in its symbol. Once it is found, the value that the symbol is
+ *   bound to is returned; if it is not found, the function returns an error.
  *
- *   args: The Value struct arguments of the let* expression
- *   frame: The current Frame struct of the interpreter
- *   returns: Result of evaluating the body of the let expression.
+ *   node: A GLOBAL_NODE.
+ *   frame: The current Frame struct of the interpreter.
+ *   returns: The value that the variable is bound to.
  */
 
-Value *evalLetStar(Value *args, Frame *frame) {
-  if (car(args) -> type != NULL_TYPE && car(args) -> type != CONS_TYPE) {
-    printf("Evaluation error: bad form in let \n");
-    texit(0);
-  }
-
-  if (args -> type == NULL_TYPE) {
-    printf("Evaluation error: no args following the bindings in let*. \n");
+static Value *runGlobal(Node *node, Frame *frame) {
+  Value **cell = globalCell(node -> value);
+  if (cell == NULL) {
+    printf("Evaluation error: symbol '%s' not found. \n", node -> value -> s);
     texit(0);
   }
+  return *cell;
+}
 
-  Value *expressions = car(args);
-  Frame *newframe;
-  Value *result;
-  Frame *prevframe = frame;
-
-  while (expressions -> type != NULL_TYPE) {
-    Value *var = talloc(sizeof(Value));
-    if (expressions -> c.car -> type == NULL_TYPE) {
-      printf("Evaluation error: null binding in let*. \n");
-      texit(0);
-    }
-
-    else if (expressions -> c.car -> type != NULL_TYPE && expressions -> c.car -> type != CONS_TYPE) {
-      printf("Evaluation error: bad form in let*. \n");
-      texit(0);
-    }
-
-    else if (expressions -> c.car -> type ==  CONS_TYPE) {
-      if (expressions -> c.car -> c.car -> type != SYMBOL_TYPE) {
-        printf("Evaluation error: left side of a let* pair doesn't have a variable. \n");
-        texit(0);
-      }
-    }
+/* Function: runIf
+ * --------------------
+ *   This function mirrors the functionality of 'if' in Scheme. It evaluates the
+ *   test, then leaves whichever branch it selects to be evaluated in its place.
+ *
+ *   node: An IF_NODE, whose children are the test and the two branches.
+ *   frame: The current Frame struct of the interpreter.
+ *   returns: The tail marker, for the selected branch.
+ */
 
-    newframe = talloc(sizeof(Frame));
-    newframe -> bindings = makeNull();
-    newframe -> parent = prevframe;
-    prevframe = newframe;
+static Value *runIf(Node *node, Frame *frame) {
+  if (IS_TRUE(execute(node -> children[0], frame))) {
+    return inTail(node -> children[1], frame, 0);
+  }
+  return inTail(node -> children[2], frame, 0);
+}
 
-    char *text = expressions -> c.car -> c.car -> s;
+/* Function: runLet
+ * --------------------
+ *   This function mirrors the functionality of a "let" expression in Scheme,
+ *   and of each binding of a "let*". It does so by creating a new frame whose
+ *   parent is the frame passed in, with a slot for each binding holding the
+ *   value of its expression, evaluated in the frame passed in. Lastly, it
+ *   leaves the body to be evaluated in this new frame. Nothing holds on to the
+ *   new frame once the body is evaluated, so it goes on the frame stack, and
+ *   execute releases it.
+ *
+ *   node: A LET_NODE, whose children are the expression of each binding and
+ *   then the body.
+ *   frame: The current Frame struct of the interpreter
+ *   returns: The tail marker, for the body.
+ */
 
-    if (newframe -> bindings -> type != NULL_TYPE) {
-      Value *curbinding = newframe -> bindings;
-      Value *checkduplicate = makeNull();
-      while (curbinding -> type != NULL_TYPE) {
-        if (!strcmp(curbinding->c.car->c.car -> s, expressions -> c.car -> c.car -> s)) {
-          checkduplicate = curbinding->c.car->c.cdr;
-          break;
-        }
-        else {
-          curbinding = curbinding -> c.cdr;
-        }
-      }
-      if (checkduplicate -> type != NULL_TYPE) {
-        printf("Evaluation error: duplicate variable in let* \n");
-        texit(0);
-      }
-    }
+static Value *runLet(Node *node, Frame *frame) {
+  Frame *newframe = tallocStackFrame(node -> slots);
+  newframe -> parent = frame;
+  gcProtect(&newframe);
 
-    var -> s = talloc(sizeof(char) * (strlen(text) + 1));
-    strcpy(var -> s,text);
-    var -> type = STR_TYPE;
-    Value *val = talloc(sizeof(Value));
-    val = eval(expressions -> c.car -> c.cdr -> c.car, newframe);
-    if (val -> type == CLOSURE_TYPE || val -> type == UNSPECIFIED_TYPE) {
-      printf("Evaluation error: Unbound variable %s in let*. \n", var -> s);
+  Value *binding = node -> value;
+  for (int i = 0; i < node -> slots; i++) {
+    Value *val = execute(node -> children[i], frame);
+    if (TYPE(val) == CLOSURE_TYPE || val == UNSPECIFIED_VALUE) {
+      printf("Evaluation error: Unbound variable %s in %s. \n", car(car(binding)) -> s, node -> text);
       texit(0);
     }
-
-    Value *pair = talloc(sizeof(Value));
-    pair -> type = CONS_TYPE;
-    pair -> c.car = var;
-    pair -> c.cdr = val;
-    newframe -> bindings = cons(pair, newframe -> bindings);
-
-    expressions = cdr(expressions);
+    newframe -> slots[i] = val;
+    binding = cdr(binding);
   }
-  Value *curbody = cdr(args);
-  while (curbody -> type != NULL_TYPE) {
-    result = eval(car(curbody), newframe);
-    curbody = cdr(curbody);
-  }
-  return result;
+  gcUnprotect(1);
+  return inTail(node -> children[node -> slots], newframe, 0);
 }
 
-/* Function: evalLetRec
+/* Function: runLetRec
  * --------------------
  *   This function mirrors the functionality of the "letrec" expression in Scheme. It
  *   does so by creating a new frame whose parent is the frame passed into the
- *   function, then creates a binding for each of the variables of the expression's argument.
- *   Each variable is bound to a Value struct of UNSPECIFIED_TYPE; after evaluating
- *   each value for each variable in this new frame, the evaluations themselves
- *   replace the original UNSPECIFIED_TYPE binding for each corresponding variable.
- *   Lastly, it evaluates the body of the let expression in this new frame.
+ *   function, with a slot for each binding. Each slot holds the unspecified
+ *   immediate; after evaluating each value for each variable in this new
+ *   frame, the evaluations themselves replace the unspecified immediate in the
+ *   slot of each corresponding variable. Lastly, it leaves the body to be
+ *   evaluated in this new frame.
  *
- *   args: The Value struct arguments of the letrec expression
+ *   node: A LETREC_NODE, whose children are the expression of each binding
+ *   and then the body.
  *   frame: The current Frame struct of the interpreter
- *   returns: Result of evaluating the body of the let expression.
+ *   returns: The tail marker, for the body.
  */
 
-Value *evalLetRec(Value *args, Frame *frame) {
-  Value *bindings = car(args);
-  Frame *newframe = talloc(sizeof(Frame));
+static Value *runLetRec(Node *node, Frame *frame) {
+  int count = node -> slots;
+  Frame *newframe = tallocStackFrame(count);
   newframe -> parent = frame;
-  newframe -> bindings = makeNull();
-  Value *result;
-
-  while (bindings -> type != NULL_TYPE) {
-    Value *pair = talloc(sizeof(Value));
-    pair -> type = CONS_TYPE;
-    pair -> c.car = bindings -> c.car -> c.car;
-    pair -> c.cdr = talloc(sizeof(Value));
-    pair -> c.cdr -> type = UNSPECIFIED_TYPE;
-    newframe -> bindings = cons(pair, newframe -> bindings);
-    bindings = cdr(bindings);
+  for (int i = 0; i < count; i++) {
+    newframe -> slots[i] = UNSPECIFIED_VALUE;
   }
 
-  newframe -> bindings = reverse(newframe -> bindings);
-  bindings = car(args);
-  Value *evaluatedvalues = makeNull();
-
-  // First evaluate each value of each variable in newframe -> bindings, within
-  // this newframe of bindings with UNSPECIFIED_TYPE's
-  while (bindings -> type != NULL_TYPE) {
-    evaluatedvalues = cons(eval(bindings -> c.car -> c.cdr -> c.car, newframe), evaluatedvalues);
-    if (eval(bindings -> c.car -> c.cdr -> c.car, newframe) -> type == UNSPECIFIED_TYPE) {
+  // First evaluate each value of each variable within newframe, while every
+  // slot still holds the unspecified immediate
+  Frame *values = tallocStackFrame(count);
+  gcProtect(&newframe);
+  gcProtect(&values);
+  for (int i = 0; i < count; i++) {
+    Value *val = execute(node -> children[i], newframe);
+    if (val == UNSPECIFIED_VALUE) {
       printf("Evaluation error: Evaluated an UNSPECIFIED_TYPE in letrec. \n");
       texit(0);
     }
-    bindings = cdr(bindings);
+    values -> slots[i] = val;
   }
+  gcUnprotect(2);
 
-  // NOW assign each evaluated value to its corresponding variable - don't forget
-  // to reverse evaluatedvalues first to match the order
-  evaluatedvalues = reverse(evaluatedvalues);
-  Value *cur_evaluated_value = evaluatedvalues;
-  Value *cur_newframe_binding = newframe -> bindings; //variables
-  while (cur_newframe_binding -> type != NULL_TYPE) {
-    car(cur_newframe_binding) -> c.cdr = cur_evaluated_value -> c.car; //set variable of car(cur_newframe_binding) -> c.car to corresponding evaluated value
-    cur_newframe_binding = cdr(cur_newframe_binding);
-    cur_evaluated_value = cdr(cur_evaluated_value);
+  // NOW assign each evaluated value to the slot of its variable, or to its
+  // box if a closure has captured it
+  for (int i = 0; i < count; i++) {
+    if (IS_BOX(newframe -> slots[i])) {
+      ((Frame *) newframe -> slots[i]) -> slots[0] = values -> slots[i];
+      gcWriteBarrier(newframe -> slots[i], values -> slots[i]);
+    }
+    else {
+      newframe -> slots[i] = values -> slots[i];
+    }
   }
 
-  Value *curbody = cdr(args);
-  while (curbody -> type != NULL_TYPE) {
-    result = eval(car(curbody), newframe);
-    curbody = cdr(curbody);
-  }
-  return result;
+  return inTail(node -> children[count], newframe, 0);
 }
 
-/* Function: evalSet
+/* Function: runSetLocal
  * --------------------
- *   This function mirrors the functionality of the "set!" expression in Scheme. It
- *   does so by looking up each of the variables of the expression's argument. It
- *   first searches the bindings of the frame passed into the function, and if
- *   the variable is not found, bubbles up to each of the linked parent frames.
- *   Lastly, it either changes the value bound to the variable that is being
- *   searched for to the value provided in args, or prints an error if the variable
- *   is not found in any frame.
+ *   This function mirrors the functionality of the "set!" expression in Scheme,
+ *   for a local variable. Its slot is found by following the parents of the
+ *   frame passed in, and holds either its value or the box it was moved into.
  *
- *   args: The Value struct arguments of the set! expression
+ *   node: A SET_LOCAL_NODE, whose child is the new value.
  *   frame: The current Frame struct of the interpreter
- *   returns: A VOID_TYPE Value struct.
+ *   returns: The void immediate.
  */
 
-Value *evalSet(Value *args, Frame *frame) {
-  Frame *cur = frame;
-  int globalframeflag = 0;
-  Value *value = makeNull();
-  Value *curbinding = makeNull();
-
-  while (cur != NULL) {
-    curbinding = cur -> bindings;
-
-    if (curbinding -> type == NULL_TYPE && globalframeflag == 1) {
-      printf("Evaluation error: symbol '%s' not found when trying to set. \n", args -> c.car -> s);
-      texit(0);
-    }
-
-    while (curbinding -> type != NULL_TYPE) {
-      if (!strcmp(curbinding->c.car->c.car -> s, args -> c.car -> s)) {
-        curbinding -> c.car -> c.cdr = eval(args -> c.cdr -> c.car, frame);
-        value = curbinding->c.car->c.cdr;
-        break;
-      }
-      else {
-        curbinding = curbinding -> c.cdr;
-      }
-    }
-
-    if (value -> type == NULL_TYPE) {
-      if (curbinding -> type != NULL_TYPE) {
-        if (curbinding -> c.car -> c.cdr -> type == NULL_TYPE) {
-          break;
-        }
-      }
-
-      cur = cur -> parent;
-      if (cur == NULL && globalframeflag == 0) {
-        cur = globalframe;
-        globalframeflag = 1;
-      }
-
-      else if (cur == NULL && globalframeflag == 1) {
-        break;
-      }
-    }
-
-    else {
-      break;
-    }
+static Value *runSetLocal(Node *node, Frame *frame) {
+  Value *value = execute(node -> children[0], frame);
+  Frame *holder = frameAt(frame, LOCAL_DEPTH(node -> value));
+  Value *box = holder -> slots[LOCAL_SLOT(node -> value)];
+  if (IS_BOX(box)) {
+    holder = (Frame *) box;
+    holder -> slots[0] = value;
+  }
+  else {
+    holder -> slots[LOCAL_SLOT(node -> value)] = value;
   }
+  gcWriteBarrier(holder, value);
+  return VOID_VALUE;
+}
 
-  if (value -> type == NULL_TYPE && curbinding -> type == NULL_TYPE) {
-    printf("Evaluation error: symbol '%s' not found. \n", args -> c.car -> s);
+/* Function: runSetGlobal
+ * --------------------
+ *   This function mirrors the functionality of the "set!" expression in Scheme,
+ *   for a global variable. It either changes the value bound to the variable,
+ *   or prints an error if the variable is not found.
+ *
+ *   node: A SET_GLOBAL_NODE, whose child is the new value.
+ *   frame: The current Frame struct of the interpreter
+ *   returns: The void immediate.
+ */
+
+static Value *runSetGlobal(Node *node, Frame *frame) {
+  if (globalCell(node -> value) == NULL) {
+    printf("Evaluation error: symbol '%s' not found when trying to set. \n", node -> value -> s);
     texit(0);
   }
-  Value *result = talloc(sizeof(Value));
-  result -> type = VOID_TYPE;
-  return result;
+  Value *value = execute(node -> children[0], frame);
+  // The value may have defined globals and moved the global frame, so the
+  // cell is looked up again.
+  *globalCell(node -> value) = value;
+  gcWriteBarrier(globalframe, value);
+  return VOID_VALUE;
 }
 
-/* Function: evalBegin
+/* Function: runBegin
  * --------------------
- *   This function mirrors the functionality of the "begin" expression in Scheme. It
- *   does so by evaluating each of the arguments values within the current frame,
- *   and only returns the last evaluated value.
+ *   This function mirrors the functionality of the "begin" expression in Scheme,
+ *   and of the body of a let. It does so by evaluating each of its expressions
+ *   within the current frame, and only returns the last evaluated value, by
+ *   leaving the last expression to be evaluated in its place.
  *
- *   args: The list of arguments for the function.
+ *   node: A BEGIN_NODE, whose children are the expressions.
  *   frame: The current Frame struct of the interpreter.
- *   returns: Either the last evaluated result of the function, or if args is
- *   NULL_TYPE, returns a VOID_TYPE.
+ *   returns: The tail marker, for the last expression, or if there are no
+ *   expressions, the void immediate.
  */
 
-Value *evalBegin(Value *args, Frame *frame) {
-  Value *result;
-  Value *cur = args;
-  if (cur -> type == NULL_TYPE) {
-    Value *result = talloc(sizeof(Value));
-    result -> type = VOID_TYPE;
+static Value *runBegin(Node *node, Frame *frame) {
+  if (node -> count == 0) {
+    return VOID_VALUE;
   }
-  else {
-    while (cur -> type != NULL_TYPE) {
-      result = eval(car(cur), frame);
-      cur = cdr(cur);
-    }
+  for (int i = 0; i < node -> count - 1; i++) {
+    execute(node -> children[i], frame);
   }
-  return result;
+  return inTail(node -> children[node -> count - 1], frame, 0);
 }
 
-/* Function: evalAnd
+/* Function: runAnd
  * --------------------
  *   This function mirrors the functionality of the "and" expression in Scheme. It
- *   does so by first evaluating every expression within the argument, and returns
- *   '#f' if there any of them evaluates to '#f'. If not, the function
- *   will return '#t'.
+ *   does so by evaluating each expression in turn, and returns '#f' as soon as
+ *   one of them evaluates to '#f'. If none do, the value of the last one is
+ *   returned, by leaving it to be evaluated in its place, or '#t' if there
+ *   are none.
  *
- *   args: The list of expressions within the argument for the function.
+ *   node: An AND_NODE, whose children are the expressions.
  *   frame: The current Frame struct of the interpreter.
- *   returns: A BOOL_TYPE Value struct that stores either "#t" or "#f" in result -> s.
+ *   returns: The #f immediate, '#t', or the tail marker for the last
+ *   expression.
  */
 
-Value *evalAnd (Value *args, Frame *frame) {
-  Value *cur = args;
-  Value *result = makeNull();
-
-  if (length(args) == 0) {
-    char *boolean = "#t";
-    result -> s = talloc(sizeof(char) * (strlen(boolean) + 1));
-    strcpy(result -> s,boolean);
-    result -> type = BOOL_TYPE;
-    return result;
+static Value *runAnd(Node *node, Frame *frame) {
+  if (node -> count == 0) {
+    return TRUE_VALUE;
   }
-
-  while (cur -> type != NULL_TYPE) {
-
-    Value *curExpr = eval(car(cur), frame);
-
-    if (curExpr -> type == INT_TYPE) {
-      result -> i = curExpr -> i;
-      result -> type = INT_TYPE;
+  for (int i = 0; i < node -> count - 1; i++) {
+    Value *result = execute(node -> children[i], frame);
+    if (!IS_TRUE(result)) {
+      return result;
     }
-
-    else if (curExpr -> type == DOUBLE_TYPE) {
-      result -> d = curExpr -> d;
-      result -> type = DOUBLE_TYPE;
-    }
-
-    else {
-      if (!strcmp(curExpr -> s, "#f")) {
-        char *boolean = "#f";
-        result -> s = talloc(sizeof(char) * (strlen(boolean) + 1));
-        strcpy(result -> s,boolean);
-        result -> type = BOOL_TYPE;
-        return result;
-      }
-
-      char *boolean = "#t";
-      result -> s = talloc(sizeof(char) * (strlen(boolean) + 1));
-      strcpy(result -> s,boolean);
-      result -> type = BOOL_TYPE;
-    }
-
-    cur = cdr(cur);
   }
-
-  return result;
+  return inTail(node -> children[node -> count - 1], frame, 0);
 }
 
-/* Function: evalOr
+/* Function: runOr
  * --------------------
  *   This function mirrors the functionality of the "or" expression in Scheme. It
- *   does so by first evaluating every expression within the argument, and returns
- *   '#t' if there any of them evaluates to '#t'. If not, the function
- *   will return '#f'.
+ *   does so by evaluating each expression in turn, and returns the value of
+ *   the first one that doesn't evaluate to '#f'. If they all do, the function
+ *   returns '#f'. Since that is the value of the last one, the last one is
+ *   left to be evaluated in its place.
  *
- *   args: The list of expressions within the argument for the function.
+ *   node: An OR_NODE, whose children are the expressions.
  *   frame: The current Frame struct of the interpreter.
- *   returns: A BOOL_TYPE Value struct that stores either "#t" or "#f" in result -> s.
+ *   returns: The value of the first true expression, the #f immediate, or
+ *   the tail marker for the last expression.
  */
 
-Value *evalOr(Value *args, Frame *frame) {
-  Value *cur = args;
-  Value *result = makeNull();
-
-  if(length(args) == 0){
-    char *boolean = "#f";
-    result -> s = talloc(sizeof(char) * (strlen(boolean) + 1));
-    strcpy(result -> s,boolean);
-    result -> type = BOOL_TYPE;
-    return result;
+static Value *runOr(Node *node, Frame *frame) {
+  if (node -> count == 0) {
+    return FALSE_VALUE;
   }
-
-  while(cur -> type != NULL_TYPE){
-
-    Value *curExpr = eval(car(cur), frame);
-
-    if(curExpr -> type == INT_TYPE){
-      result -> i = curExpr -> i;
-      result -> type = INT_TYPE;
-    }
-
-    else if(curExpr -> type == DOUBLE_TYPE){
-      result -> d = curExpr -> d;
-      result -> type = DOUBLE_TYPE;
-    }
-
-    else{
-      if(!strcmp(curExpr -> s, "#t")){
-        char *boolean = "#t";
-        result -> s = talloc(sizeof(char) * (strlen(boolean) + 1));
-        strcpy(result -> s,boolean);
-        result -> type = BOOL_TYPE;
-
-        return result;
-      }
-
-      char *boolean = "#f";
-      result -> s = talloc(sizeof(char) * (strlen(boolean) + 1));
-      strcpy(result -> s,boolean);
-      result -> type = BOOL_TYPE;
+  for (int i = 0; i < node -> count - 1; i++) {
+    Value *result = execute(node -> children[i], frame);
+    if (IS_TRUE(result)) {
+      return result;
     }
-
-    cur = cdr(cur);
   }
-
-  return result;
+  return inTail(node -> children[node -> count - 1], frame, 0);
 }
 
-/* Function: lookUpSymbol
+/* Function: runCond
  * --------------------
- *   This function looks up unknown symbols within the bindings of the current
- *   frame that is passed in. If it is not found, the search goes through the
- *   bindings of every frame that is the parent of every other frame, until it
- *   reaches the global frame. Once it is found, the value that the symbol is
- *   bound to is returned; it if is not found in any frame, the function returns an error.
+ *   This function mirrors the functionality of the "cond" expression in Scheme. It
+ *   does so by evaluating each test in turn, and leaves the expression of the
+ *   first one that is true to be evaluated in its place; the test of an else
+ *   clause always is.
  *
- *   expr: The symbol to search for.
+ *   node: A COND_NODE, whose children are the test and expression of each
+ *   clause.
  *   frame: The current Frame struct of the interpreter.
- *   returns: The value that the expression was bound to, or an error if it is not found.
- */
-
-Value *lookUpSymbol(Value *expr, Frame *frame) {
-  Frame *cur = frame;
-  int globalframeflag = 0;
-  Value *value = makeNull();
-  Value *curbinding = makeNull();
-  while (cur != NULL) {
-    curbinding = cur -> bindings;
-    if (curbinding -> type == NULL_TYPE && globalframeflag == 1) {
-      printf("Evaluation error: symbol '%s' not found. \n", expr -> s);
-      texit(0);
-    }
-
-    while (curbinding -> type != NULL_TYPE) {
-      if (!strcmp(curbinding->c.car->c.car -> s, expr -> s)) {
-        value = curbinding->c.car->c.cdr;
-        break;
-      }
-      else {
-        curbinding = curbinding -> c.cdr;
-      }
-    }
-
-    if (value -> type == NULL_TYPE) {
-      if (curbinding -> type != NULL_TYPE) {
-        if (curbinding -> c.car -> c.cdr -> type == NULL_TYPE) {
-          break;
-        }
-      }
-      cur = cur -> parent;
-      if (cur == NULL && globalframeflag == 0) {
-        cur = globalframe;
-        globalframeflag = 1;
-      }
-      else if (cur == NULL && globalframeflag == 1) {
-        break;
-      }
-    }
+ *   returns: The tail marker for the expression tied to the first true test,
+ *   or void if there is none.
+ */
 
-    else {
-      break;
+static Value *runCond(Node *node, Frame *frame) {
+  for (int i = 0; i < node -> count; i += 2) {
+    if (IS_TRUE(execute(node -> children[i], frame))) {
+      return inTail(node -> children[i + 1], frame, 0);
     }
   }
+  return VOID_VALUE;
+}
 
-  if (value -> type == NULL_TYPE && curbinding -> type == NULL_TYPE) {
-    printf("Evaluation error: symbol '%s' not found. \n", expr -> s);
-    texit(0);
-  }
+/* Function: runDefine
+ * --------------------
+ *   This function mirrors the functionality of the "define" expression in Scheme. It
+ *   does so by binding the variable in the global frame to its value, which is
+ *   evaluated in the global environment, wherever the define is.
+ *
+ *   node: A DEFINE_NODE, whose child is the value.
+ *   frame: The current Frame struct of the interpreter, which is unused.
+ *   returns: The void immediate.
+ */
 
-  return value;
+static Value *runDefine(Node *node, Frame *frame) {
+  Value *val = execute(node -> children[0], NULL);
+  defineGlobal(node -> value, val);
+  return VOID_VALUE;
 }
 
-/* Function: evalCond
+/* Function: captureVariable
  * --------------------
- *   This function mirrors the functionality of the "cond" expression in Scheme. It
- *   does so by evaluating each test case within the argument. It returns the evaluated
- *   value associated with the first expression that evaluates to true. If no expressions
- *   contain a value that returns true, it returns the evaluated expression that
- *   is tied to "else" in the argument.
+ *   Finds the value of a free variable of a closure being made, to copy into
+ *   the frame of the closure. A mutable variable has to stay shared between
+ *   the two, so it is first moved into a box, a frame of one slot, unless it
+ *   is already in one.
  *
- *   args: The list of expressions within the argument for the function.
  *   frame: The current Frame struct of the interpreter.
- *   returns: A BOOL_TYPE Value struct that stores "#t", or the evaluated expression
- *   tied to "else".
+ *   address: Where the variable is, relative to frame.
+ *   returns: The value of the variable, or its box.
  */
 
-Value *evalCond(Value *args, Frame *frame) {
-  Value *cur = args;
-  Value *result;
-  while (cur -> type != NULL_TYPE) {
-    if (cur -> c.car -> c.car -> type == SYMBOL_TYPE) {
-      if (!strcmp(cur -> c.car -> c.car -> s, "else")) {
-        result = eval(cur -> c.car -> c.cdr -> c.car, frame);
-        break;
-      }
-    }
-    else {
-      Value *boolean = eval(cur -> c.car -> c.car, frame);
-      if (!strcmp(boolean -> s, "#t")) {
-        result = eval(cur -> c.car -> c.cdr -> c.car, frame);
-        break;
-      }
-      else if (!strcmp(boolean -> s, "#f")) {
-        result = eval(cur -> c.car -> c.cdr -> c.car, frame);
-        cur = cdr(cur);
-      }
-    }
+static Value *captureVariable(Frame *frame, Value *address) {
+  Frame *holder = frameAt(frame, LOCAL_DEPTH(address));
+  Value *value = holder -> slots[LOCAL_SLOT(address)];
+  if (LOCAL_MUTABLE(address) && !IS_BOX(value)) {
+    Frame *box = tallocFrame(1);
+    box -> slots[0] = value;
+    value = (Value *) box;
+    holder -> slots[LOCAL_SLOT(address)] = value;
+    gcWriteBarrier(holder, value);
   }
-
-  return result;
+  return value;
 }
 
-/* Function: evalQuote
+/* Function: runLambda
  * --------------------
- *   This function mirrors the functionality of the "quote" expression in Scheme. It
- *   does so by evaluating the arguments of the expression and simply returning
- *   the "car" of the list of arguments.
+ *   This function mirrors the functionality of the "lambda" expression in Scheme. It
+ *   does so by creating a CLOSURE_TYPE Value struct that holds the lambda and
+ *   a frame of its own with just the free variables of the body.
  *
- *   args: The list of expressions within the argument for the function.
+ *   node: A LAMBDA_NODE, whose children are the body and then where each free
+ *   variable is.
  *   frame: The current Frame struct of the interpreter.
- *   returns: The "car" of the list of arguments
+ *   returns: A CLOSURE_TYPE Value struct.
  */
 
-Value *evalQuote(Value *args, Frame *frame) {
-  if (length(args) > 1) {
-    printf("Evaluation error: multiple arguments to quote \n");
-    texit(0);
-  }
-  else if (args -> type == NULL_TYPE) {
-    printf("Evaluation error \n");
-    texit(0);
+Value *runLambda(Node *node, Frame *frame) {
+  Value *closure = tallocValue(CLOSURE_TYPE);
+  closure -> cl.lambda = node;
+  closure -> cl.frame = NULL;
+  int captured = node -> count - 1;
+  if (captured > 0) {
+    closure -> cl.frame = tallocFrame(captured);
+    for (int i = 0; i < captured; i++) {
+      closure -> cl.frame -> slots[i] = captureVariable(frame, node -> children[i + 1] -> value);
+    }
   }
-  return car(args);
+  return closure;
 }
 
-/* Function: evalDefine
+/* Function: applyPrimitive
  * --------------------
- *   This function mirrors the functionality of the "define" expression in Scheme. It
- *   does so by storing the variables of the argument within the bindings of the
- *   global frame, binding it to the evaluated values corresponding to these variables.
+ *   Applies a function that isn't a closure, which has to be a primitive.
+ *   The number of arguments is checked against the arity it was bound with,
+ *   and the arguments are handed over where they already are, so the call
+ *   allocates nothing but what the primitive returns.
  *
- *   args: The list of expressions within the argument for the function.
- *   frame: The current Frame struct of the interpreter.
- *   returns: A VOID_TYPE Value struct.
+ *   function: The function.
+ *   args: The arguments, on the stack of the virtual machine or in a frame.
+ *   count: The number of arguments.
+ *   call: The CALL_NODE of the call, which allocations are charged to, or
+ *   NULL for none.
+ *   returns: The result of the primitive.
  */
 
-Value *evalDefine(Value *args, Frame *frame) {
-  if (args -> type == NULL_TYPE) {
-    printf("Evaluation error: no args following define. \n");
+Value *applyPrimitive(Value *function, Value **args, int count, Node *call) {
+  if (TYPE(function) != PRIMITIVE_TYPE) {
+    printf("Evaluation error: attempt to apply something that isn't a procedure. \n");
     texit(0);
   }
-  Value *var = talloc(sizeof(Value));
-  if (args -> c.car -> type != SYMBOL_TYPE) {
-    printf("Evaluation error: define must bind to a symbol. \n");
+  if (count < function -> prim.minArgs
+      || (function -> prim.maxArgs >= 0 && count > function -> prim.maxArgs)) {
+    printf("%s", function -> prim.arityError);
     texit(0);
   }
-  char *text = args -> c.car -> s;
-  var -> s = talloc(sizeof(char) * (strlen(text) + 1));
-  strcpy(var -> s,text);
-  var -> type = STR_TYPE;
-  Value *val = talloc(sizeof(Value));
-  if (args -> c.cdr -> type == NULL_TYPE) {
-    printf("Evaluation error: no value following the symbol in define. \n");
-    texit(0);
+  if (heapProfiling && call != NULL && IS_CONS(call -> source)) {
+    void *outerSite = heapProfileSite(call -> source);
+    Value *result = function -> prim.pf(count, args);
+    heapProfileSite(outerSite);
+    return result;
   }
-  val = eval(args -> c.cdr -> c.car, frame);
-
-  Value *pair = talloc(sizeof(Value));
-  pair -> type = CONS_TYPE;
-  pair -> c.car = var;
-  pair -> c.cdr = val;
-  frame -> bindings = cons(pair, frame -> bindings);
-
-  Value *result = talloc(sizeof(Value));
-  result -> type = VOID_TYPE;
-  return result;
+  return function -> prim.pf(count, args);
 }
 
-/* Function: evalLambda
+/* How many arguments of a call of a primitive runCall evaluates into a buffer
+ * on the C stack; a call with more gets one from malloc. */
+#define ARGUMENT_BUFFER 8
+
+/* Function: runCall
  * --------------------
- *   This function mirrors the functionality of the "lambda" expression in Scheme. It
- *   does so by creating a CLOSURE_TYPE Value struct to store the symbols and body
- *   within it.
+ *   This function applies a function to its arguments. The function could be
+ *   one of the Scheme primitive functions bound in the global frame, which
+ *   gets the evaluated arguments in a buffer, or a lambda closure, whose
+ *   arguments are evaluated straight into the frame of the call. Closures copy
+ *   what they capture rather than holding on to frames, so the frame of a call
+ *   never outlives it and goes on the frame stack. The body of a closure is
+ *   left to be evaluated in its place, and execute moves the frame down over
+ *   the frames it replaces, so tail calls run in constant space.
  *
- *   args: The list of symbols and function body within the argument for the function.
+ *   node: A CALL_NODE, whose children are the function and the arguments.
  *   frame: The current Frame struct of the interpreter.
- *   returns: A CLOSURE_TYPE Value struct.
+ *   returns: The result of applying a primitive to the arguments, or the
+ *   tail marker for the body of a closure.
  */
 
-Value *evalLambda(Value *args, Frame *frame) {
-  if (args -> type == NULL_TYPE) {
-    printf("Evaluation error: no args following lambda. \n");
-    texit(0);
-  }
-
-  Value *params = car(args);
-  Value *closure = talloc(sizeof(Value));
-  closure -> cl.paramNames = makeNull();
-  closure -> type = CLOSURE_TYPE;
-  while (params -> type != NULL_TYPE) {
-    if (car(params) -> type != SYMBOL_TYPE) {
-      printf("Evaluation error: formal parameters for lambda must be symbols. \n");
-      texit(0);
-    }
-    closure -> cl.paramNames = cons(car(params), closure -> cl.paramNames);
-    params = cdr(params);
-  }
-
-  closure -> cl.paramNames = reverse(closure -> cl.paramNames);
-  Value *current = closure -> cl.paramNames;
+static Value *runCall(Node *node, Frame *frame) {
+  Value *function = execute(node -> children[0], frame);
+  Value *result;
 
-  while (current -> type != NULL_TYPE) {
-    Value *var_to_compare = car(current);
-    Value *next_val = cdr(current);
-    while (next_val -> type != NULL_TYPE) {
-      if (!strcmp(var_to_compare -> s, car(next_val) -> s)) {
-        printf("Evaluation error: duplicate identifier in lambda. \n");
-        texit(0);
-      }
-      else {
-        next_val = cdr(next_val);
+  if (TYPE(function) == CLOSURE_TYPE) {
+    Node *lambda = function -> cl.lambda;
+    Node *body = jitMode ? hotBody(lambda) : lambda -> children[0];
+    Frame *applyframe = tallocStackFrame(body -> kind == NATIVE_NODE ? body -> slots : lambda -> slots);
+    applyframe -> parent = function -> cl.frame;
+    gcProtect(&applyframe);
+
+    // Missing arguments are left as the empty list, and extra ones ignored.
+    for (int i = 1; i < node -> count; i++) {
+      Value *arg = execute(node -> children[i], frame);
+      if (i <= lambda -> slots) {
+        applyframe -> slots[i - 1] = arg;
       }
     }
-    current = cdr(current);
+    gcUnprotect(1);
+    return inTail(body, applyframe, 1);
   }
 
-  Value *body = cdr(args);
-  if (body -> type == NULL_TYPE) {
-    printf("Evaluation error: no code in lambda following parameters. \n");
-    texit(0);
+  // The arguments of anything else go in a buffer the collector doesn't see,
+  // so each of its slots is protected, rather than in a frame on the frame
+  // stack that would be counted as allocated.
+  int count = node -> count - 1;
+  Value *buffer[ARGUMENT_BUFFER];
+  Value **args = count <= ARGUMENT_BUFFER ? buffer : malloc(count * sizeof(Value *));
+  gcProtect(&function);
+  for (int i = 0; i < count; i++) {
+    args[i] = NULL;
+    gcProtect(&args[i]);
   }
-
-  closure -> cl.functionCode = body;
-  Frame *env = talloc(sizeof(Frame));
-  env = frame;
-  closure -> cl.frame = env;
-  return closure;
+  for (int i = 0; i < count; i++) {
+    args[i] = execute(node -> children[i + 1], frame);
+  }
+  result = applyPrimitive(function, args, count, NULL);
+  gcUnprotect(count + 1);
+  if (args != buffer) {
+    free(args);
+  }
+  return result;
 }
 
-/* Function: evalEach
+/* Function: specialFormSymbol
  * --------------------
- *   This function evaluates each of the arguments being passed into it, returning
- *   a list of the evaluated arguments.
+ *   Adds a special form to the dispatch table of the analysis pass.
  *
- *   args: The list of arguments to evaluate.
- *   frame: The current Frame struct of the interpreter.
- *   returns: A Value struct list of evaluated arguments.
+ *   name: The name of the special form.
+ *   analyzer: The function that analyzes it.
+ *   returns: The interned symbol of the name, which now carries the form.
  */
 
-Value *evalEach(Value *args, Frame *frame) {
-  Value *cur = args;
-  Value *result = makeNull();
-  while (cur -> type != NULL_TYPE) {
-    result = cons(eval(car(cur), frame), result);
-    cur = cdr(cur);
-  }
-  if (result -> type == CONS_TYPE) {
-    if (result -> c.car -> type == NULL_TYPE && result -> c.cdr -> type == CONS_TYPE) {
-      if (result -> c.cdr -> c.car -> type == NULL_TYPE) {
-        return result;
-      }
-    }
-  }
-  Value *reversed = reverse(result);
-  return reversed;
+static Value *specialFormSymbol(char *name, specialForm analyzer) {
+  Value *symbol = intern(name);
+  specialFormCount = specialFormCount + 1;
+  specialForms[specialFormCount] = analyzer;
+  symbol -> sym.form = specialFormCount;
+  return symbol;
 }
 
-/* Function: apply
+/* Function: setUpSpecialForms
  * --------------------
- *   This function applies the arguments passed into this function to the Scheme
- *   function that is also passed into it. The Scheme function could be a pointer
- *   to one of the previously binded functions in the global frame, or it can be
- *   a lambda closure (returned by evalLambda).
- *
- *   function: Pointer to a Scheme function or to a lambda closure.
- *   args: The arguments to be applied to function passed in.
- *   returns: The result of applying the arguments to the function passed in.
+ *   Fills the dispatch table of the analysis pass, and sets up the symbols of
+ *   the special forms for the analyzers that look for them.
  */
 
-Value *apply(Value *function, Value *args) {
-  Frame *applyframe = talloc(sizeof(Frame));
-  Value *result;
-
-  if (function -> type == CLOSURE_TYPE) {
-    applyframe -> bindings = talloc(sizeof(Value));
-    applyframe -> bindings -> type = NULL_TYPE;
-    Value *funcvalue = function; // get closure
-    applyframe -> parent = funcvalue -> cl.frame;
-    Value *cur = funcvalue -> cl.paramNames;
-
-    while (cur -> type != NULL_TYPE) {
-      Value *var = talloc(sizeof(Value));
-      char *text = car(cur) -> s;
-      var -> s = talloc(sizeof(char) * (strlen(text) + 1));
-      strcpy(var -> s,text);
-      var -> type = STR_TYPE;
-
-      Value *val = talloc(sizeof(Value));
-      if (length(args) == 0) {
-        val = makeNull();
-      }
-      else {
-        val = car(args);
-      }
-
-      Value *pair = talloc(sizeof(Value));
-      pair -> type = CONS_TYPE;
-      pair -> c.car = var;
-      pair -> c.cdr = val;
+static void setUpSpecialForms() {
+  if (specialFormCount > 0) {
+    return;
+  }
+  ifSymbol = specialFormSymbol("if", analyzeIf);
+  letSymbol = specialFormSymbol("let", analyzeLet);
+  letStarSymbol = specialFormSymbol("let*", analyzeLetStar);
+  letRecSymbol = specialFormSymbol("letrec", analyzeLetRec);
+  quoteSymbol = specialFormSymbol("quote", analyzeQuote);
+  defineSymbol = specialFormSymbol("define", analyzeDefine);
+  lambdaSymbol = specialFormSymbol("lambda", analyzeLambda);
+  setSymbol = specialFormSymbol("set!", analyzeSet);
+  beginSymbol = specialFormSymbol("begin", analyzeBegin);
+  andSymbol = specialFormSymbol("and", analyzeAnd);
+  orSymbol = specialFormSymbol("or", analyzeOr);
+  condSymbol = specialFormSymbol("cond", analyzeCond);
+  elseSymbol = intern("else");
+}
 
-      args = cdr(args);
-      cur = cdr(cur);
+/* The expression that a handler left to be evaluated in its place, the frame
+ * to evaluate it in, and whether that is the new frame of a call. */
+static Node *tailNode;
+static Frame *tailFrame;
+static int tailCall;
 
-      applyframe -> bindings = cons(pair, applyframe -> bindings);
-    }
-    result = eval(funcvalue -> cl.functionCode -> c.car, applyframe);
-  }
+/* Function: inTail
+ * --------------------
+ *   Leaves an expression in tail position to be evaluated by execute in place
+ *   of the one being evaluated, rather than evaluating it from the handler,
+ *   so that the C stack doesn't grow.
+ *
+ *   node: The expression in tail position.
+ *   frame: The frame to evaluate it in.
+ *   call: Whether frame is the new frame of a call, which replaces every
+ *   frame made since.
+ *   returns: The tail marker, for the handler to return.
+ */
 
-  else { // apply Scheme function
-    result = function -> pf(args);
-  }
-  return result;
+Value *inTail(Node *node, Frame *frame, int call) {
+  tailNode = node;
+  tailFrame = frame;
+  tailCall = call;
+  return TAIL_VALUE;
 }
 
-/* Function: eval
+/* Function: execute
  * --------------------
- *   This function evaluates each type of expression passed into it from other
- *   functions in this code, and returns the corresponding result.
+ *   Evaluates a node by calling its handler. This is the safe point of the
+ *   collector, so handlers have to protect what they hold across a call to
+ *   it; the frame being evaluated in is protected here. A handler that leaves
+ *   an expression in tail position to be evaluated in its place gets it
+ *   evaluated here in a loop, so a loop written as tail calls doesn't grow
+ *   the C stack. What handlers put on the frame stack for the expression is
+ *   released once it is evaluated, and before that by each tail call, whose
+ *   frame is moved down to where the frames it replaces started.
  *
- *   expr: The expression to evaluate.
+ *   node: The node to evaluate.
  *   frame: The current Frame struct of the interpreter.
- *   returns: The result of evaluating the expression.
+ *   returns: The result of evaluating the node.
  */
 
-Value *eval(Value *expr, Frame *frame) {
+Value *execute(Node *node, Frame *frame) {
   Value *result;
-  switch (expr->type)  {
-    case INT_TYPE: {
-      result = expr;
-      break;
+  void *mark = stackMark();
+  gcProtect(&frame);
+  while (1) {
+    gcSafePoint();
+    if (heapProfiling && IS_CONS(node -> source)) {
+      void *outerSite = heapProfileSite(node -> source);
+      result = node -> run(node, frame);
+      heapProfileSite(outerSite);
     }
-    case DOUBLE_TYPE: {
-      result = expr;
-      break;
+    else {
+      result = node -> run(node, frame);
     }
-    case SYMBOL_TYPE: {
-      return lookUpSymbol(expr, frame);
+    if (result != TAIL_VALUE) {
       break;
     }
-    case CONS_TYPE: {
-      Value *first = car(expr);
-      Value *args = cdr(expr);
-
-      if (!strcmp(first->s,"if")) {
-        result = evalIf(args,frame);
-      }
+    node = tailNode;
+    frame = tailCall ? stackMoveFrame(tailFrame, mark) : tailFrame;
+  }
+  stackRelease(mark);
+  gcUnprotect(1);
+  return result;
+}
 
-      else if (!strcmp(first->s,"let")) {
-        result = evalLet(args,frame);
-      }
+/* Function: eval
+ * --------------------
+ *   This function evaluates a top-level expression, by analyzing it into a
+ *   tree of nodes and evaluating that, or compiling it to bytecode for the
+ *   virtual machine.
+ *
+ *   expr: The expression to evaluate.
+ *   returns: The result of evaluating the expression.
+ */
 
-      else if (!strcmp(first->s,"let*")) {
-        result = evalLetStar(args,frame);
-      }
+Value *eval(Value *expr) {
+  if (vmMode) {
+    return runBytecode(compileTopLevel(analyzeTopLevel(expr)));
+  }
+  return execute(analyzeTopLevel(expr), NULL);
+}
 
-      else if (!strcmp(first->s,"letrec")) {
-        result = evalLetRec(args,frame);
-      }
+/* Function: globalValue
+ * --------------------
+ *   Looks up a global variable for compiled code, machine code or C, like
+ *   runGlobal.
+ *
+ *   symbol: The variable.
+ *   returns: Its value.
+ */
 
-      else if (!strcmp(first->s,"quote")) {
-        result = evalQuote(args,frame);
-      }
+Value *globalValue(Value *symbol) {
+  Value **cell = globalCell(symbol);
+  if (cell == NULL) {
+    printf("Evaluation error: symbol '%s' not found. \n", symbol -> s);
+    texit(0);
+  }
+  return *cell;
+}
 
-      else if (!strcmp(first->s,"define")) {
-        result = evalDefine(args, globalframe);
-      }
-      else if (!strcmp(first->s,"lambda")) {
-        result = evalLambda(args, frame);
-      }
-      else if (!strcmp(first->s,"set!")) {
-        result = evalSet(args, frame);
-      }
-      else if (!strcmp(first->s,"begin")) {
-        result = evalBegin(args, frame);
-      }
+/* Function: callFrame
+ * --------------------
+ *   Makes the frame of a call of a closure from machine code, on the frame
+ *   stack, with room for the extra slots of its body if it is compiled too.
+ *
+ *   function: The closure.
+ *   body: The body to evaluate, from hotBody.
+ *   args: The arguments.
+ *   count: The number of arguments.
+ *   call: The CALL_NODE, which the frame is charged to, or NULL for none.
+ *   returns: The frame.
+ */
 
-      else if (!strcmp(first->s,"and")) {
-        result = evalAnd(args, frame);
-      }
+Frame *callFrame(Value *function, Node *body, Value **args, int count, Node *call) {
+  Node *lambda = function -> cl.lambda;
+  int size = body -> kind == NATIVE_NODE ? body -> slots : lambda -> slots;
+  Frame *frame;
+  if (heapProfiling && call != NULL && IS_CONS(call -> source)) {
+    void *outerSite = heapProfileSite(call -> source);
+    frame = tallocStackFrame(size);
+    heapProfileSite(outerSite);
+  }
+  else {
+    frame = tallocStackFrame(size);
+  }
+  frame -> parent = function -> cl.frame;
+  if (count > lambda -> slots) {
+    count = lambda -> slots;
+  }
+  for (int i = 0; i < count; i++) {
+    frame -> slots[i] = args[i];
+  }
+  return frame;
+}
 
-      else if (!strcmp(first->s,"or")) {
-        result = evalOr(args, frame);
-      }
-      else if (!strcmp(first->s,"cond")) {
-        result = evalCond(args, frame);
-      }
+/* Function: applyFunction
+ * --------------------
+ *   Applies a function to arguments for compiled C code, the way runCall
+ *   does.
+ *
+ *   function: The function, a closure or a primitive.
+ *   args: The arguments.
+ *   count: The number of arguments.
+ *   returns: The result of the call.
+ */
 
-      else {
-        // If not a special form, evaluate the first, evaluate the args, then
-        // apply the first to the args.
-       Value *evaledOperator = eval(first, frame);
-       Value *evaledArgs = evalEach(args, frame);
-       return apply(evaledOperator,evaledArgs);
-      }
-      break;
-    }
-    case STR_TYPE: {
-      result = expr;
-      break;
-    }
-    case OPEN_TYPE: {
-      result = expr;
-      break;
-    }
-    case CLOSE_TYPE: {
-      result = expr;
-      break;
-    }
-    case BOOL_TYPE: {
-      result = expr;
-      break;
-    }
-    case PTR_TYPE: {
-      result = expr;
-      break;
-    }
-    case NULL_TYPE: {
-      break;
-    }
-    case VOID_TYPE: {
-      break;
-    }
-    case CLOSURE_TYPE: {
-      break;
-    }
-    case PRIMITIVE_TYPE: {
-      break;
-    }
-    case UNSPECIFIED_TYPE: {
-      break;
-    }
+Value *applyFunction(Value *function, Value **args, int count) {
+  if (TYPE(function) != CLOSURE_TYPE) {
+    return applyPrimitive(function, args, count, NULL);
   }
-
+  Node *body = function -> cl.lambda -> children[0];
+  void *mark = stackMark();
+  Value *result = execute(body, callFrame(function, body, args, count, NULL));
+  stackRelease(mark);
   return result;
-}
\ No newline at end of file
+}
@@ -0,0 +1,702 @@
+/* jit.c
+ * Author: Khalid Hussain
+ * --------------------
+ * This program is the JIT of --jit, which compiles the bodies of the lambdas
+ * that interpreter.c applies often to x86-64 machine code.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/mman.h>
+#include "headers/linkedlist.h"
+#include "headers/value.h"
+#include "headers/talloc.h"
+#include "headers/interpreter.h"
+#include "headers/node.h"
+#include "headers/vm.h"
+#include "headers/jit.h"
+
+/* The JIT. Once a lambda has been applied JIT_THRESHOLD times, its body is
+ * compiled to x86-64 machine code, one template of instructions per node,
+ * into memory that can be executed. The code is a node handler of its own,
+ * run by a NATIVE_NODE that takes the place of the body, so execute runs it
+ * like any other node. It only handles fixnum arithmetic and comparisons,
+ * if, cond, and, or, begin, variables and calls; a body with anything else
+ * stays interpreted.
+ *
+ * The code keeps the frame in rbx, and the value of the node being evaluated
+ * in rax. Values that have to survive a call, such as the function and the
+ * arguments already evaluated, are kept in extra slots at the end of the
+ * frame, where the collector finds them. Calls go back through jitCall and
+ * jitTailCall, which apply the function as runCall does.
+ */
+
+#define JIT_THRESHOLD 100
+#define JIT_REGION_SIZE (1 << 20)
+#define JIT_BRANCHES 16 /* The most branches of an and, or or cond that the JIT compiles */
+
+/* The machine code being assembled, and the extra slots of the frame that
+ * hold values while a node is evaluated. */
+struct assembler {
+  unsigned char *code;
+  int length;
+  int capacity;
+  int params; /* The number of parameters, which come before the extra slots */
+  int temps; /* The extra slots in use */
+  int maxTemps;
+  int failed; /* Whether the body has a node the JIT doesn't handle */
+};
+
+/* The memory that machine code is copied into, which is only ever writable
+ * or executable, never both. Code goes at the end of the last region; every
+ * region is kept so that it can be unmapped at exit. */
+static unsigned char **jitRegions = NULL;
+static int jitRegionCount = 0;
+static int jitRegionCapacity = 0;
+static unsigned char *jitRegion = NULL;
+static size_t jitUsed = 0;
+
+/* The NATIVE_NODE of each compiled lambda, and what printJitStats reports. */
+static Node **nativeNodes = NULL;
+static int nativeCount = 0;
+static int nativeCapacity = 0;
+static int jitFailures = 0;
+static size_t jitBytes = 0;
+static double jitCompileTime = 0;
+
+/* Function: emitByte
+ * --------------------
+ *   Appends a byte of machine code.
+ *
+ *   a: The assembler.
+ *   byte: The byte.
+ */
+
+static void emitByte(struct assembler *a, int byte) {
+  a -> code = growBuffer(a -> code, &a -> capacity, a -> length + 1, 1);
+  a -> code[a -> length] = (unsigned char) byte;
+  a -> length = a -> length + 1;
+}
+
+/* Function: emitBytes
+ * --------------------
+ *   Appends the bytes of an instruction.
+ *
+ *   a: The assembler.
+ *   bytes: The bytes.
+ *   count: How many there are.
+ */
+
+static void emitBytes(struct assembler *a, const unsigned char *bytes, int count) {
+  for (int i = 0; i < count; i++) {
+    emitByte(a, bytes[i]);
+  }
+}
+
+/* Function: emitInt32
+ * --------------------
+ *   Appends a 32-bit immediate or displacement, little-endian.
+ *
+ *   a: The assembler.
+ *   value: The value.
+ *   returns: Where it is in the code, to patch a jump.
+ */
+
+static int emitInt32(struct assembler *a, int32_t value) {
+  int at = a -> length;
+  for (int i = 0; i < 4; i++) {
+    emitByte(a, (int) ((uint32_t) value >> (8 * i)) & 0xFF);
+  }
+  return at;
+}
+
+/* Function: emitInt64
+ * --------------------
+ *   Appends a 64-bit immediate, little-endian.
+ *
+ *   a: The assembler.
+ *   value: The value.
+ */
+
+static void emitInt64(struct assembler *a, uint64_t value) {
+  for (int i = 0; i < 8; i++) {
+    emitByte(a, (int) (value >> (8 * i)) & 0xFF);
+  }
+}
+
+/* Function: emitJumpTo
+ * --------------------
+ *   Appends a jump whose target isn't known yet.
+ *
+ *   a: The assembler.
+ *   opcode: The bytes of the jump, which take a 32-bit offset.
+ *   count: How many bytes that is.
+ *   returns: Where the offset is, for patchJumpTo.
+ */
+
+static int emitJumpTo(struct assembler *a, const unsigned char *opcode, int count) {
+  emitBytes(a, opcode, count);
+  return emitInt32(a, 0);
+}
+
+/* Function: patchJumpTo
+ * --------------------
+ *   Points a jump at the next instruction to be assembled.
+ *
+ *   a: The assembler.
+ *   at: Where the offset of the jump is.
+ */
+
+static void patchJumpTo(struct assembler *a, int at) {
+  int32_t offset = a -> length - (at + 4);
+  memcpy(a -> code + at, &offset, 4);
+}
+
+/* Function: slotOffset
+ * --------------------
+ *   returns: The offset of a slot from the start of a Frame struct.
+ */
+
+static int32_t slotOffset(int slot) {
+  return (int32_t) (offsetof(Frame, slots) + slot * sizeof(Value *));
+}
+
+/* Function: emitTemp
+ * --------------------
+ *   Appends the instruction that moves rax to an extra slot of the frame, or
+ *   one of them back into a register.
+ *
+ *   a: The assembler.
+ *   modrm: The ModRM byte for [rbx + disp32] and the register, such as 0x83
+ *   for rax.
+ *   opcode: 0x89 to store the register in the slot, 0x8B to load it.
+ *   temp: The extra slot.
+ */
+
+static void emitTemp(struct assembler *a, int opcode, int modrm, int temp) {
+  unsigned char bytes[] = {0x48, opcode, modrm};
+  emitBytes(a, bytes, 3);
+  emitInt32(a, slotOffset(a -> params + temp));
+}
+
+/* Function: emitCallTo
+ * --------------------
+ *   Appends a call of a C function, through rax.
+ *
+ *   a: The assembler.
+ *   function: The function.
+ */
+
+static void emitCallTo(struct assembler *a, void *function) {
+  emitByte(a, 0x48);
+  emitByte(a, 0xB8);
+  emitInt64(a, (uint64_t) (uintptr_t) function);
+  emitByte(a, 0xFF);
+  emitByte(a, 0xD0);
+}
+
+/* Function: emitConstant
+ * --------------------
+ *   Appends the instruction that moves a constant into a register.
+ *
+ *   a: The assembler.
+ *   opcode: The bytes that move a 64-bit immediate into the register, such as
+ *   0x48 0xB8 for rax.
+ *   value: The constant.
+ */
+
+static void emitConstant(struct assembler *a, int rex, int opcode, const void *value) {
+  emitByte(a, rex);
+  emitByte(a, opcode);
+  emitInt64(a, (uint64_t) (uintptr_t) value);
+}
+
+/* Function: emitCompareFalse
+ * --------------------
+ *   Appends the comparison of rax with #f, followed by a conditional jump.
+ *
+ *   a: The assembler.
+ *   jump: 0x84 to jump if it is #f, 0x85 if it isn't.
+ *   returns: Where the offset of the jump is.
+ */
+
+static int emitCompareFalse(struct assembler *a, int jump) {
+  emitByte(a, 0x48);
+  emitByte(a, 0x3D);
+  emitInt32(a, (int32_t) (uintptr_t) FALSE_VALUE);
+  unsigned char bytes[] = {0x0F, jump};
+  return emitJumpTo(a, bytes, 2);
+}
+
+/* Function: jitUnbox
+ * --------------------
+ *   Takes the value of a mutable local variable for machine code out of its
+ *   box, if it is in one.
+ *
+ *   value: What the slot of the variable holds.
+ *   returns: The value of the variable.
+ */
+
+static Value *jitUnbox(Value *value) {
+  return IS_BOX(value) ? ((Frame *) value) -> slots[0] : value;
+}
+
+/* Function: jitCall
+ * --------------------
+ *   Applies a function for machine code, to arguments in the extra slots of
+ *   its frame, and returns the result.
+ *
+ *   frame: The frame of the machine code.
+ *   first: The slot of the function, which the arguments follow.
+ *   count: The number of arguments.
+ *   call: The CALL_NODE.
+ *   returns: The result of the call.
+ */
+
+static Value *jitCall(Frame *frame, int first, int count, Node *call) {
+  Value *function = frame -> slots[first];
+  if (TYPE(function) != CLOSURE_TYPE) {
+    return applyPrimitive(function, &frame -> slots[first + 1], count, call);
+  }
+  Node *body = hotBody(function -> cl.lambda);
+  void *mark = stackMark();
+  Frame *applyframe = callFrame(function, body, &frame -> slots[first + 1], count, call);
+  Value *result = execute(body, applyframe);
+  stackRelease(mark);
+  return result;
+}
+
+/* Function: jitTailCall
+ * --------------------
+ *   Applies a function for machine code, like jitCall, from a call in tail
+ *   position. The body of a closure is left for execute to evaluate, as
+ *   runCall does, so the machine code returns the tail marker.
+ *
+ *   frame: The frame of the machine code.
+ *   first: The slot of the function, which the arguments follow.
+ *   count: The number of arguments.
+ *   call: The CALL_NODE.
+ *   returns: The result of a primitive, or the tail marker.
+ */
+
+static Value *jitTailCall(Frame *frame, int first, int count, Node *call) {
+  Value *function = frame -> slots[first];
+  if (TYPE(function) != CLOSURE_TYPE) {
+    return applyPrimitive(function, &frame -> slots[first + 1], count, call);
+  }
+  Node *body = hotBody(function -> cl.lambda);
+  return inTail(body, callFrame(function, body, &frame -> slots[first + 1], count, call), 1);
+}
+
+/* Function: assembleCall
+ * --------------------
+ *   Appends the call of jitCall or jitTailCall, for a function and arguments
+ *   in the extra slots of the frame.
+ *
+ *   a: The assembler.
+ *   first: The extra slot of the function.
+ *   count: The number of arguments.
+ *   call: The CALL_NODE.
+ *   tail: Whether the call is in tail position.
+ */
+
+static void assembleCall(struct assembler *a, int first, int count, Node *call, int tail) {
+  unsigned char movRdiRbx[] = {0x48, 0x89, 0xDF};
+  emitBytes(a, movRdiRbx, 3);
+  emitByte(a, 0xBE);
+  emitInt32(a, a -> params + first);
+  emitByte(a, 0xBA);
+  emitInt32(a, count);
+  emitConstant(a, 0x48, 0xB9, call);
+  emitCallTo(a, tail ? (void *) jitTailCall : (void *) jitCall);
+}
+
+static void assembleNode(struct assembler *a, Node *node, int tail);
+
+/* Function: assembleArithmetic
+ * --------------------
+ *   Appends a call of '+', '-', '<', '>' or '=' on two arguments. When the
+ *   function is still the primitive and both arguments are fixnums, the
+ *   result is worked out in registers, the same way the primitive does,
+ *   and otherwise the call is made.
+ *
+ *   a: The assembler.
+ *   node: The CALL_NODE.
+ *   op: Which it is, from arithmeticOpcode.
+ *   tail: Whether the call is in tail position.
+ */
+
+static void assembleArithmetic(struct assembler *a, Node *node, int op, int tail) {
+  static Value *(*primitives[])(int, Value **) = {primitiveAdd, primitiveMinus, primitiveLessThan, primitiveGreaterThan, primitiveEqual};
+  int first = a -> temps;
+  a -> temps = a -> temps + 3;
+  if (a -> temps > a -> maxTemps) {
+    a -> maxTemps = a -> temps;
+  }
+  for (int i = 0; i < 3; i++) {
+    assembleNode(a, node -> children[i], 0);
+    emitTemp(a, 0x89, 0x83, first + i);
+  }
+  emitTemp(a, 0x8B, 0x93, first);      // mov rdx, function
+  emitTemp(a, 0x8B, 0x8B, first + 1);  // mov rcx, first argument
+
+  int slow[6];
+  int slowCount = 5;
+  unsigned char testDl[] = {0xF6, 0xC2, 0x07};   // test dl, 7
+  unsigned char jne[] = {0x0F, 0x85};
+  unsigned char je[] = {0x0F, 0x84};
+  emitBytes(a, testDl, 3);
+  slow[0] = emitJumpTo(a, jne, 2);
+  unsigned char cmpType[] = {0x80, 0x7A, 0xFF, PRIMITIVE_TYPE}; // cmp byte [rdx - 1], PRIMITIVE_TYPE
+  emitBytes(a, cmpType, 4);
+  slow[1] = emitJumpTo(a, jne, 2);
+  emitConstant(a, 0x49, 0xBB, (void *) primitives[op - OP_ADD]); // mov r11, primitive
+  unsigned char cmpPf[] = {0x4C, 0x39, 0x1A};   // cmp [rdx], r11
+  emitBytes(a, cmpPf, 3);
+  slow[2] = emitJumpTo(a, jne, 2);
+  unsigned char testCl[] = {0xF6, 0xC1, 0x01};   // test cl, 1
+  emitBytes(a, testCl, 3);
+  slow[3] = emitJumpTo(a, je, 2);
+  unsigned char testAl[] = {0xA8, 0x01};         // test al, 1
+  emitBytes(a, testAl, 2);
+  slow[4] = emitJumpTo(a, je, 2);
+
+  if (op == OP_ADD || op == OP_SUB) {
+    // The tagged fixnums are added or subtracted as they are, with the tag
+    // of one taken off first, so the result is tagged and overflows just
+    // when the integer does. An overflow is left to the primitive, which
+    // makes it a double.
+    if (op == OP_ADD) {
+      unsigned char add[] = {0x4C, 0x8D, 0x41, 0xFF,  // lea r8, [rcx - 1]
+                             0x49, 0x01, 0xC0};       // add r8, rax
+      emitBytes(a, add, 7);
+    }
+    else {
+      unsigned char sub[] = {0x48, 0x83, 0xE8, 0x01,  // sub rax, 1
+                             0x49, 0x89, 0xC8,        // mov r8, rcx
+                             0x49, 0x29, 0xC0};       // sub r8, rax
+      emitBytes(a, sub, 10);
+    }
+    unsigned char jo[] = {0x0F, 0x80};
+    slow[slowCount] = emitJumpTo(a, jo, 2);
+    slowCount = slowCount + 1;
+    unsigned char result[] = {0x4C, 0x89, 0xC0};       // mov rax, r8
+    emitBytes(a, result, 3);
+  }
+  else {
+    // Tagged fixnums compare the same way as the integers they hold.
+    unsigned char cmpRcxRax[] = {0x48, 0x39, 0xC1}; // cmp rcx, rax
+    emitBytes(a, cmpRcxRax, 3);
+    emitConstant(a, 0x48, 0xB8, FALSE_VALUE);
+    emitConstant(a, 0x49, 0xB8, TRUE_VALUE);
+    int condition = op == OP_LESS ? 0x4C : op == OP_GREATER ? 0x4F : 0x44;
+    unsigned char cmov[] = {0x49, 0x0F, condition, 0xC0}; // cmovcc rax, r8
+    emitBytes(a, cmov, 4);
+  }
+  unsigned char jmp[] = {0xE9};
+  int done = emitJumpTo(a, jmp, 1);
+  for (int i = 0; i < slowCount; i++) {
+    patchJumpTo(a, slow[i]);
+  }
+  assembleCall(a, first, 2, node, tail);
+  patchJumpTo(a, done);
+  a -> temps = first;
+}
+
+/* Function: assembleNode
+ * --------------------
+ *   Appends the template of a node, which leaves its value in rax, or marks
+ *   the body as one the JIT doesn't handle.
+ *
+ *   a: The assembler.
+ *   node: The node.
+ *   tail: Whether the node is in tail position, where calls are tail calls.
+ */
+
+static void assembleNode(struct assembler *a, Node *node, int tail) {
+  unsigned char jmp[] = {0xE9};
+  int jumps[JIT_BRANCHES];
+  int end, op;
+
+  switch (node -> kind) {
+  case CONSTANT_NODE:
+    emitConstant(a, 0x48, 0xB8, node -> value);
+    break;
+
+  case LOCAL_NODE:
+    if (LOCAL_DEPTH(node -> value) == 0) {
+      unsigned char load[] = {0x48, 0x8B, 0x83}; // mov rax, [rbx + slot]
+      emitBytes(a, load, 3);
+    }
+    else {
+      unsigned char movRaxRbx[] = {0x48, 0x89, 0xD8};
+      emitBytes(a, movRaxRbx, 3);
+      for (int i = 0; i < LOCAL_DEPTH(node -> value); i++) {
+        unsigned char parent[] = {0x48, 0x8B, 0x80}; // mov rax, [rax + parent]
+        emitBytes(a, parent, 3);
+        emitInt32(a, (int32_t) offsetof(Frame, parent));
+      }
+      unsigned char load[] = {0x48, 0x8B, 0x80}; // mov rax, [rax + slot]
+      emitBytes(a, load, 3);
+    }
+    emitInt32(a, slotOffset(LOCAL_SLOT(node -> value)));
+    if (LOCAL_MUTABLE(node -> value)) {
+      unsigned char movRdiRax[] = {0x48, 0x89, 0xC7};
+      emitBytes(a, movRdiRax, 3);
+      emitCallTo(a, (void *) jitUnbox);
+    }
+    break;
+
+  case GLOBAL_NODE:
+    emitConstant(a, 0x48, 0xBF, node -> value);
+    emitCallTo(a, (void *) globalValue);
+    break;
+
+  case IF_NODE:
+    assembleNode(a, node -> children[0], 0);
+    jumps[0] = emitCompareFalse(a, 0x84);
+    assembleNode(a, node -> children[1], tail);
+    end = emitJumpTo(a, jmp, 1);
+    patchJumpTo(a, jumps[0]);
+    assembleNode(a, node -> children[2], tail);
+    patchJumpTo(a, end);
+    break;
+
+  case BEGIN_NODE:
+    if (node -> count == 0) {
+      emitConstant(a, 0x48, 0xB8, VOID_VALUE);
+    }
+    for (int i = 0; i < node -> count; i++) {
+      assembleNode(a, node -> children[i], tail && i == node -> count - 1);
+    }
+    break;
+
+  case AND_NODE:
+  case OR_NODE:
+    if (node -> count == 0) {
+      emitConstant(a, 0x48, 0xB8, node -> kind == AND_NODE ? TRUE_VALUE : FALSE_VALUE);
+      break;
+    }
+    if (node -> count > JIT_BRANCHES) {
+      a -> failed = 1;
+      break;
+    }
+    for (int i = 0; i < node -> count - 1; i++) {
+      assembleNode(a, node -> children[i], 0);
+      jumps[i] = emitCompareFalse(a, node -> kind == AND_NODE ? 0x84 : 0x85);
+    }
+    assembleNode(a, node -> children[node -> count - 1], tail);
+    for (int i = 0; i < node -> count - 1; i++) {
+      patchJumpTo(a, jumps[i]);
+    }
+    break;
+
+  case COND_NODE:
+    if (node -> count / 2 > JIT_BRANCHES) {
+      a -> failed = 1;
+      break;
+    }
+    for (int i = 0; i < node -> count; i += 2) {
+      assembleNode(a, node -> children[i], 0);
+      int next = emitCompareFalse(a, 0x84);
+      assembleNode(a, node -> children[i + 1], tail);
+      jumps[i / 2] = emitJumpTo(a, jmp, 1);
+      patchJumpTo(a, next);
+    }
+    emitConstant(a, 0x48, 0xB8, VOID_VALUE);
+    for (int i = 0; i < node -> count; i += 2) {
+      patchJumpTo(a, jumps[i / 2]);
+    }
+    break;
+
+  case CALL_NODE:
+    op = arithmeticOpcode(node);
+    if (op >= 0) {
+      assembleArithmetic(a, node, op, tail);
+      break;
+    }
+    end = a -> temps;
+    a -> temps = a -> temps + node -> count;
+    if (a -> temps > a -> maxTemps) {
+      a -> maxTemps = a -> temps;
+    }
+    for (int i = 0; i < node -> count; i++) {
+      assembleNode(a, node -> children[i], 0);
+      emitTemp(a, 0x89, 0x83, end + i);
+    }
+    assembleCall(a, end, node -> count - 1, node, tail);
+    a -> temps = end;
+    break;
+
+  default:
+    a -> failed = 1;
+    break;
+  }
+}
+
+/* Function: unmapJitRegions
+ * --------------------
+ *   Unmaps the memory of the machine code, at exit.
+ */
+
+static void unmapJitRegions() {
+  for (int i = 0; i < jitRegionCount; i++) {
+    munmap(jitRegions[i], JIT_REGION_SIZE);
+  }
+  free(jitRegions);
+  jitRegions = NULL;
+  jitRegionCount = 0;
+  jitRegion = NULL;
+}
+
+/* Function: mapJitRegion
+ * --------------------
+ *   Maps a new region for machine code, which the code compiled from now on
+ *   goes into. It starts out writable; writeNative makes it executable.
+ *
+ *   returns: Whether the region could be mapped.
+ */
+
+static int mapJitRegion() {
+  unsigned char *region = mmap(NULL, JIT_REGION_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (region == MAP_FAILED) {
+    return 0;
+  }
+  if (jitRegions == NULL) {
+    atexit(unmapJitRegions);
+  }
+  jitRegions = growBuffer(jitRegions, &jitRegionCapacity, jitRegionCount + 1, sizeof(unsigned char *));
+  jitRegions[jitRegionCount] = region;
+  jitRegionCount = jitRegionCount + 1;
+  jitRegion = region;
+  jitUsed = 0;
+  return 1;
+}
+
+/* Function: writeNative
+ * --------------------
+ *   Copies assembled machine code to the end of the current region. The
+ *   region is only writable while the code is copied, and executable again
+ *   afterwards.
+ *
+ *   bytes: The machine code.
+ *   length: Its size in bytes.
+ *   returns: Where the code was copied, or NULL if the region couldn't be
+ *   made writable or executable.
+ */
+
+static unsigned char *writeNative(const unsigned char *bytes, int length) {
+  if (mprotect(jitRegion, JIT_REGION_SIZE, PROT_READ | PROT_WRITE) != 0) {
+    return NULL;
+  }
+  unsigned char *code = jitRegion + jitUsed;
+  memcpy(code, bytes, length);
+  if (mprotect(jitRegion, JIT_REGION_SIZE, PROT_READ | PROT_EXEC) != 0) {
+    return NULL;
+  }
+  jitUsed = (jitUsed + length + 15) & ~(size_t) 15;
+  return code;
+}
+
+/* Function: compileNative
+ * --------------------
+ *   Compiles the body of a lambda to machine code, and puts a NATIVE_NODE
+ *   that runs it in place of the body. A lambda whose body the JIT doesn't
+ *   handle is left as it is.
+ *
+ *   lambda: The LAMBDA_NODE.
+ *   returns: The body of the lambda, compiled or not.
+ */
+
+static Node *compileNative(Node *lambda) {
+#if defined(__x86_64__)
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  struct assembler a = {NULL, 0, 0, lambda -> slots, 0, 0, 0};
+
+  unsigned char prologue[] = {0x53, 0x48, 0x89, 0xF3}; // push rbx; mov rbx, rsi
+  emitBytes(&a, prologue, 4);
+  assembleNode(&a, lambda -> children[0], 1);
+  unsigned char epilogue[] = {0x5B, 0xC3};             // pop rbx; ret
+  emitBytes(&a, epilogue, 2);
+
+  if (!a.failed && jitRegion != NULL && jitUsed + a.length > JIT_REGION_SIZE) {
+    jitRegion = NULL;
+  }
+  if (!a.failed && jitRegion == NULL && a.length <= JIT_REGION_SIZE) {
+    mapJitRegion();
+  }
+  unsigned char *code = NULL;
+  if (!a.failed && jitRegion != NULL) {
+    code = writeNative(a.code, a.length);
+  }
+  free(a.code);
+  if (code == NULL) {
+    jitFailures = jitFailures + 1;
+    return lambda -> children[0];
+  }
+  jitBytes = jitBytes + a.length;
+
+  Node *native = makeNode(NATIVE_NODE, (nodeHandler) code, 2, lambda -> children[0] -> source);
+  native -> slots = lambda -> slots + a.maxTemps;
+  native -> children[0] = lambda -> children[0];
+  native -> children[1] = lambda;
+  lambda -> children[0] = native;
+
+  nativeNodes = growBuffer(nativeNodes, &nativeCapacity, nativeCount + 1, sizeof(Node *));
+  nativeNodes[nativeCount] = native;
+  nativeCount = nativeCount + 1;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  jitCompileTime += (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+  return native;
+#else
+  jitFailures = jitFailures + 1;
+  return lambda -> children[0];
+#endif
+}
+
+/* Function: hotBody
+ * --------------------
+ *   Counts an application of a lambda, compiling its body once it has been
+ *   applied JIT_THRESHOLD times.
+ *
+ *   lambda: The LAMBDA_NODE of the closure being applied.
+ *   returns: The body to evaluate, which is a NATIVE_NODE once compiled.
+ */
+
+Node *hotBody(Node *lambda) {
+  Node *body = lambda -> children[0];
+  body -> calls = body -> calls + 1;
+  if (body -> kind == NATIVE_NODE) {
+    return body;
+  }
+  lambda -> calls = lambda -> calls + 1;
+  if (lambda -> calls == JIT_THRESHOLD) {
+    body = compileNative(lambda);
+  }
+  return body;
+}
+
+/* Function: printJitStats
+ * --------------------
+ *   Prints each lambda compiled by the JIT to stderr, with the number of
+ *   calls of its body that were interpreted before it was compiled and that
+ *   ran as machine code after.
+ */
+
+void printJitStats() {
+  fprintf(stderr, "JIT: %d lambdas compiled, %d left interpreted, %zu bytes of machine code, %.3f ms compiling\n",
+          nativeCount, jitFailures, jitBytes, jitCompileTime);
+  for (int i = 0; i < nativeCount; i++) {
+    Node *native = nativeNodes[i];
+    Node *body = native -> children[0];
+    char site[64];
+    describeSite(native -> children[1] -> source, site, sizeof(site));
+    fprintf(stderr, "JIT: %s: %d calls interpreted, %d compiled\n",
+            site, body -> calls, native -> calls);
+  }
+}
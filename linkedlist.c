@@ -16,15 +16,14 @@
 
 /* Function: makeNull
  * --------------------
- *   Creates a new NULL_TYPE Value struct.
+ *   Returns the empty list. It is an immediate, so nothing is allocated and
+ *   every empty list is the same pointer.
  *
- *   returns: This new NULL_TYPE Value struct.
+ *   returns: The NULL_TYPE immediate.
  */
 
 Value *makeNull() {
- Value *val = talloc(sizeof(Value));
- val -> type = NULL_TYPE;
- return val;
+ return NULL_VALUE;
 }
 
 /* Function: cons
@@ -39,8 +38,7 @@ Value *makeNull() {
  */
 
 Value *cons(Value *newCar, Value *newCdr) {
-  Value *val = talloc(sizeof(Value));
-  val -> type = CONS_TYPE;
+  Value *val = tallocValue(CONS_TYPE);
   val -> c.car = newCar;
   val -> c.cdr = newCdr;
   return val;
@@ -57,18 +55,20 @@ Value *cons(Value *newCar, Value *newCdr) {
  */
 
 Value *reverse(Value *list) {
+  // This relinks the cells in place, which a cdr-coded run can't do.
+  assert(!IS_CONS(list) || !(((struct header *) list - 1) -> flags & CDR_NEXT_FLAG));
   Value *prev = makeNull();
   Value *next = makeNull();
 
   while (true) {
-    if (list -> type == NULL_TYPE) {
+    if (TYPE(list) == NULL_TYPE) {
       return list;
     }
 
-    else if (next -> type == NULL_TYPE) {
+    else if (TYPE(next) == NULL_TYPE) {
       next = list -> c.cdr;
       list -> c.cdr = prev;
-      if (next -> type != NULL_TYPE) {
+      if (TYPE(next) != NULL_TYPE) {
         prev = next -> c.car;
       }
       else {
@@ -78,12 +78,12 @@ Value *reverse(Value *list) {
 
     else {
       next = next -> c.cdr;
-      if (prev -> type == NULL_TYPE) {
+      if (TYPE(prev) == NULL_TYPE) {
         break;
       }
       else {
         list = cons(prev, list);
-        if (next -> type != NULL_TYPE) {
+        if (TYPE(next) != NULL_TYPE) {
           prev = next -> c.car;
         }
         else {
@@ -111,13 +111,18 @@ Value *car(Value *list) {
 
 /* Function: cdr
  * --------------------
- *   Function to obtain the "cdr" value of the linked list, for less typing.
+ *   Function to obtain the "cdr" value of the linked list, for less typing. A
+ *   cell of a cdr-coded run made by makeList has no cdr field; its cdr is the
+ *   cell right after it.
  *
  *   list: The linked list to grab the "cdr" of.
  *   returns: The "cdr" of the passed in linked list.
  */
 
 Value *cdr(Value *list){
+  if (((struct header *) list - 1) -> flags & CDR_NEXT_FLAG) {
+    return (Value *) ((char *) list + sizeof(struct header) + sizeof(Value *));
+  }
   Value *val = list -> c.cdr;
   return val;
 }
@@ -131,18 +136,14 @@ Value *cdr(Value *list){
  */
 
 bool isNull(Value *value) {
-  Value *val = value;
-  if (val -> type == NULL_TYPE) {
-    return true;
-  }
-  else {
-    return false;
-  }
+  return IS_NULL(value);
 }
 
 /* Function: length
  * --------------------
- *   Function to find the length of the linked list.
+ *   Function to find the length of the linked list. Each cdr-coded run knows
+ *   how many cells follow any of its cells, so the whole run is skipped at
+ *   once rather than walked.
  *
  *   value: The Value struct to check the length of.
  *   returns: The length of the given Value struct.
@@ -151,9 +152,31 @@ bool isNull(Value *value) {
 int length(Value *value){
   int len = 0;
   Value *cur = value;
-  while (isNull(cur) != true) {
+  while (IS_CONS(cur)) {
+    struct header *header = (struct header *) cur - 1;
+    if (header -> flags & CDR_NEXT_FLAG) {
+      len = len + header -> size;
+      cur = (Value *) ((char *) cur + header -> size * (sizeof(struct header) + sizeof(Value *)));
+    }
     len = len + 1;
-    cur = cdr(cur);
+    cur = cur -> c.cdr;
   }
   return len;
+}
+
+/* Function: makeList
+ * --------------------
+ *   Creates a proper list of the given length, laid out as one contiguous
+ *   cdr-coded run rather than a chain of separately allocated cons cells. The
+ *   elements are meant to be filled in afterwards through their "car".
+ *
+ *   count: The length of the list.
+ *   returns: The new list, whose elements are all the empty list.
+ */
+
+Value *makeList(int count) {
+  if (count == 0) {
+    return makeNull();
+  }
+  return tallocList(count);
 }
\ No newline at end of file
@@ -6,22 +6,156 @@
  * then it parses the Scheme code with parser.c by creating nested linked list
  * in accordance with the number of open/close parenthesis, and finally it
  * interprets the resulting tree with interpreter.c
+ *
+ * The following flags are accepted:
+ *   --gc-stats          print a report of garbage collections at exit
+ *   --gc-min-heap=N     don't collect until N bytes are in use
+ *   --gc-growth=F       let the heap grow F times past what survived a collection
+ *   --no-gc             never collect garbage
+ *   --regions           reclaim each top-level expression's garbage once it is printed
+ *   --mem-report        print how many objects and bytes of each type were allocated at exit
+ *   --heap-profile[=N]  print the N expressions that allocated the most at exit (default 10)
+ *   --vm                run each expression on the bytecode virtual machine,
+ *                       which deep non-tail recursion needs
+ *   --stack-stats       print how deep the calls went and what the stacks cost at exit
+ *   --jit               compile the bodies of lambdas that are called often to machine code
+ *   --jit-stats         print what the JIT compiled and how often it ran at exit
+ *   --emit-c            print a C file that runs the program instead of running it
+ *   --opt               fold constants, propagate constant globals and inline small lambdas
+ *   --opt-report        turn on --opt, and print what it transformed at exit
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "headers/tokenizer.h"
 #include "headers/value.h"
 #include "headers/linkedlist.h"
 #include "headers/parser.h"
 #include "headers/talloc.h"
 #include "headers/interpreter.h"
+#include "headers/vm.h"
+#include "headers/jit.h"
+#include "headers/optimize.h"
+#include "headers/emitc.h"
 
-int main() {
+/* Function: usage
+ * --------------------
+ *   Prints the flags that are accepted and exits.
+ */
+
+static void usage() {
+    printf("Usage: interpreter [--gc-stats] [--gc-min-heap=N] [--gc-growth=F] [--no-gc] [--regions] [--mem-report] [--heap-profile[=N]] [--vm] [--stack-stats] [--jit] [--jit-stats] [--emit-c] [--opt] [--opt-report] < file.scm\n");
+    printf("Deep recursion that isn't in tail position needs --vm: without it, such calls are made on the C stack.\n");
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    int gcStats = 0;
+    int memReport = 0;
+    int heapProfile = 0;
+    int stackStats = 0;
+    int jitStats = 0;
+    int emitC = 0;
+    int optReport = 0;
+    int gcEnabled = 1;
+    size_t gcMinHeap = 4 << 20;
+    double gcGrowth = 2.0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--gc-stats")) {
+            gcStats = 1;
+        }
+        else if (!strncmp(argv[i], "--gc-min-heap=", 14)) {
+            gcMinHeap = strtoul(argv[i] + 14, NULL, 10);
+        }
+        else if (!strncmp(argv[i], "--gc-growth=", 12)) {
+            gcGrowth = strtod(argv[i] + 12, NULL);
+            if (gcGrowth < 1.0) {
+                usage();
+            }
+        }
+        else if (!strcmp(argv[i], "--no-gc")) {
+            gcEnabled = 0;
+        }
+        else if (!strcmp(argv[i], "--regions")) {
+            setRegionMode(1);
+        }
+        else if (!strcmp(argv[i], "--mem-report")) {
+            memReport = 1;
+        }
+        else if (!strcmp(argv[i], "--vm")) {
+            setVmMode(1);
+        }
+        else if (!strcmp(argv[i], "--stack-stats")) {
+            stackStats = 1;
+        }
+        else if (!strcmp(argv[i], "--jit")) {
+            setJitMode(1);
+        }
+        else if (!strcmp(argv[i], "--jit-stats")) {
+            setJitMode(1);
+            jitStats = 1;
+        }
+        else if (!strcmp(argv[i], "--emit-c")) {
+            emitC = 1;
+        }
+        else if (!strcmp(argv[i], "--opt")) {
+            setOptMode(1);
+        }
+        else if (!strcmp(argv[i], "--opt-report")) {
+            setOptMode(1);
+            setOptReport();
+            optReport = 1;
+        }
+        else if (!strcmp(argv[i], "--heap-profile")) {
+            heapProfile = 10;
+        }
+        else if (!strncmp(argv[i], "--heap-profile=", 15)) {
+            heapProfile = atoi(argv[i] + 15);
+            if (heapProfile < 1) {
+                usage();
+            }
+        }
+        else {
+            usage();
+        }
+    }
+    gcConfigure(gcEnabled, gcMinHeap, gcGrowth);
+    if (heapProfile) {
+        setHeapProfile();
+    }
 
     Value *list = tokenize();
     Value *tree = parse(list);
+    if (emitC) {
+        emitProgram(tree);
+        if (optReport) {
+            printOptReport();
+        }
+        tfree();
+        return 0;
+    }
     interpret(tree);
 
+    if (gcStats) {
+        gcPrintStats();
+    }
+    if (memReport) {
+        memPrintReport();
+    }
+    if (heapProfile) {
+        printHeapProfile(heapProfile);
+    }
+    if (stackStats) {
+        printStackStats();
+    }
+    if (jitStats) {
+        printJitStats();
+    }
+    if (optReport) {
+        printOptReport();
+    }
     tfree();
     return 0;
 }
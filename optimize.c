@@ -0,0 +1,531 @@
+/* optimize.c
+ * Author: Khalid Hussain
+ * --------------------
+ * This program is the optimizer of --opt, which rewrites the nodes of each
+ * top-level expression that interpreter.c analyzes before it is run.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "headers/linkedlist.h"
+#include "headers/value.h"
+#include "headers/talloc.h"
+#include "headers/interpreter.h"
+#include "headers/node.h"
+#include "headers/optimize.h"
+
+/* The optimizer. With --opt, each top-level expression is rewritten after
+ * it is analyzed, before it is evaluated or compiled. A call of a pure
+ * primitive whose arguments are all constants is folded into its result,
+ * and an if whose test is a constant into the branch it selects. The
+ * variables it relies on are the ones that are only ever bound to one
+ * value: a primitive that the program never defines or assigns, or a
+ * variable the program defines once, in a top-level define, and never
+ * assigns. Such a variable is bound for good once its define has been
+ * evaluated, so a reference to one bound to a constant is replaced by the
+ * constant, and a call of one bound to a small lambda by the body of the
+ * lambda. Until then, it is left alone, so a use of it before its define
+ * still reports that it isn't found.
+ */
+
+#define INLINE_LIMIT 16 /* The most nodes the body of a lambda that is inlined can have */
+
+/* What the optimizer did */
+typedef enum {
+  OPT_FOLDED, OPT_PRUNED, OPT_PROPAGATED, OPT_INLINED
+} optKind;
+
+/* A transformation, recorded for --opt-report */
+struct optRecord {
+  optKind kind;
+  Value *site; /* The expression transformed, or the top-level expression around a variable */
+  Value *subject; /* The variable propagated or inlined, or the value folded to */
+  Value *value; /* The value a variable was propagated as */
+  int form; /* Which top-level expression, counting from 1, it was done in */
+};
+
+static int optMode = 0; /* Whether each top-level expression is optimized after it is analyzed */
+static int optReport = 0; /* Whether what the optimizer does is recorded for --opt-report */
+static Value *optSite = NULL; /* The top-level expression being optimized, which what is done to a variable is reported at */
+static int optForm = 0; /* How many top-level expressions have been optimized */
+static Value *optDefined = NULL; /* The variable of every define in the program */
+static Value *optTopDefined = NULL; /* The variable of every top-level define */
+static Value *optAssigned = NULL; /* The variable of every set! in the program */
+static Value *inlinedAt = NULL; /* The call whose copy of a body is being optimized, which folds in it are reported at */
+static struct optRecord *optRecords = NULL;
+static int optRecordCount = 0;
+static int optRecordCapacity = 0;
+
+static Node *optimize(Node *node, int inlining);
+
+/* Function: foldNumber
+ * --------------------
+ *   returns: Whether a constant is a number, for an arithmetic primitive.
+ */
+
+static int foldNumber(Value *value) {
+  return IS_FIXNUM(value) || TYPE(value) == DOUBLE_TYPE;
+}
+
+/* Function: foldPair
+ * --------------------
+ *   returns: Whether a constant is a pair, for car.
+ */
+
+static int foldPair(Value *value) {
+  return IS_CONS(value);
+}
+
+/* Function: foldList
+ * --------------------
+ *   returns: Whether a constant is a pair or the empty list, for cdr.
+ */
+
+static int foldList(Value *value) {
+  return IS_CONS(value) || IS_NULL(value);
+}
+
+/* Function: foldAny
+ * --------------------
+ *   returns: 1, since null? takes anything.
+ */
+
+static int foldAny(Value *value) {
+  (void) value;
+  return 1;
+}
+
+/* The pure primitives that calls are folded of, with the check each argument
+ * has to pass for the call to be free of errors. */
+static const struct {
+  Value *(*function)(int argc, Value **argv);
+  int (*check)(Value *value);
+} foldable[] = {
+  {primitiveAdd, foldNumber},
+  {primitiveMinus, foldNumber},
+  {primitiveMultiply, foldNumber},
+  {primitiveLessThan, foldNumber},
+  {primitiveGreaterThan, foldNumber},
+  {primitiveEqual, foldNumber},
+  {primitiveCar, foldPair},
+  {primitiveCdr, foldList},
+  {primitiveNull, foldAny}
+};
+
+/* Function: setOptMode
+ * --------------------
+ *   Turns the optimizer on or off.
+ *
+ *   enabled: 1 to optimize each top-level expression before evaluating it.
+ */
+
+void setOptMode(int enabled) {
+  optMode = enabled;
+}
+
+/* Function: setOptReport
+ * --------------------
+ *   Makes the optimizer record what it does, for printOptReport.
+ */
+
+void setOptReport() {
+  optReport = 1;
+}
+
+/* Function: startOptimizer
+ * --------------------
+ *   Finds the variables of the program that are defined or assigned, which
+ *   tell the optimizer which it can rely on. Does nothing without --opt.
+ *
+ *   tree: The tree of parsed Scheme expressions.
+ */
+
+void startOptimizer(Value *tree) {
+  if (!optMode) {
+    return;
+  }
+  gcAddRoot(&optDefined);
+  gcAddRoot(&optTopDefined);
+  gcAddRoot(&optAssigned);
+  optDefined = collectDefined(tree, makeNull());
+  optAssigned = collectAssigned(tree, makeNull());
+  optTopDefined = makeNull();
+  for (Value *cur = tree; IS_CONS(cur); cur = cdr(cur)) {
+    Value *expr = car(cur);
+    if (IS_CONS(expr) && car(expr) == defineSymbol && IS_CONS(cdr(expr)) &&
+        TYPE(car(cdr(expr))) == SYMBOL_TYPE) {
+      optTopDefined = cons(car(cdr(expr)), optTopDefined);
+    }
+  }
+}
+
+/* Function: boundFor
+ * --------------------
+ *   Finds the value of a global variable that is only ever bound to one
+ *   value, once it is bound.
+ *
+ *   symbol: The variable.
+ *   returns: Its value, or NULL if it isn't such a variable, or isn't bound
+ *   yet.
+ */
+
+static Value *boundFor(Value *symbol) {
+  int defines = countSymbol(optDefined, symbol);
+  if (countSymbol(optAssigned, symbol) > 0 || defines > 1 ||
+      countSymbol(optTopDefined, symbol) != defines) {
+    return NULL;
+  }
+  Value **cell = globalCell(symbol);
+  if (cell == NULL) {
+    return NULL;
+  }
+  // A primitive the program defines is bound before its define is evaluated.
+  if (defines == 1 && TYPE(*cell) == PRIMITIVE_TYPE) {
+    return NULL;
+  }
+  return *cell;
+}
+
+/* Function: recordTransformation
+ * --------------------
+ *   Records a transformation for --opt-report.
+ *
+ *   kind: What was done.
+ *   site: The expression transformed, or the top-level expression around
+ *   the variable.
+ *   subject: The variable, or the value folded to.
+ *   value: The value a variable was propagated as, or NULL.
+ */
+
+static void recordTransformation(optKind kind, Value *site, Value *subject, Value *value) {
+  optRecords = growBuffer(optRecords, &optRecordCapacity, optRecordCount + 1, sizeof(struct optRecord));
+  struct optRecord entry = {kind, site, subject, value, optForm};
+  optRecords[optRecordCount] = entry;
+  optRecordCount = optRecordCount + 1;
+}
+
+/* Function: foldCall
+ * --------------------
+ *   Folds a call of a pure primitive whose arguments are constants, by
+ *   applying the primitive now. Only a result that isn't allocated by the
+ *   call is kept, since nodes aren't traced by the collector: an immediate,
+ *   or part of the quoted data of the argument.
+ *
+ *   node: A CALL_NODE, whose children are already optimized.
+ *   returns: The CONSTANT_NODE of the result, or the node if it can't be
+ *   folded.
+ */
+
+static Node *foldCall(Node *node) {
+  Node *operator = node -> children[0];
+  if (operator -> kind != GLOBAL_NODE) {
+    return node;
+  }
+  Value *function = boundFor(operator -> value);
+  if (function == NULL || TYPE(function) != PRIMITIVE_TYPE) {
+    return node;
+  }
+  int count = node -> count - 1;
+  for (int i = 0; i < (int) (sizeof(foldable) / sizeof(foldable[0])); i++) {
+    if (function -> prim.pf != foldable[i].function) {
+      continue;
+    }
+    if (count < function -> prim.minArgs
+        || (function -> prim.maxArgs >= 0 && count > function -> prim.maxArgs)) {
+      return node;
+    }
+    Value **args = talloc(sizeof(Value *) * (count + 1));
+    for (int j = 0; j < count; j++) {
+      Node *arg = node -> children[j + 1];
+      if (arg -> kind != CONSTANT_NODE || !foldable[i].check(arg -> value)) {
+        return node;
+      }
+      args[j] = arg -> value;
+    }
+    Value *result = applyPrimitive(function, args, count, NULL);
+    if (IS_POINTER(result) && !(count == 1 && IS_CONS(args[0]) &&
+                                (result == car(args[0]) || result == cdr(args[0])))) {
+      return node;
+    }
+    if (optReport) {
+      recordTransformation(OPT_FOLDED, inlinedAt != NULL ? inlinedAt : node -> source, result, NULL);
+    }
+    return constantNode(result, node -> source);
+  }
+  return node;
+}
+
+/* Function: inlinable
+ * --------------------
+ *   Tells whether the body of a lambda can take the place of a call of it: it
+ *   makes no frames or closures of its own, doesn't assign or define, and
+ *   doesn't refer to the variable the lambda is bound to, so inlining it
+ *   can't go on forever.
+ *
+ *   node: The body, or a node in it.
+ *   name: The variable the lambda is bound to.
+ *   size: How many nodes have been counted so far, which is updated.
+ *   returns: 1 if it can, 0 otherwise.
+ */
+
+static int inlinable(Node *node, Value *name, int *size) {
+  *size = *size + 1;
+  if (*size > INLINE_LIMIT) {
+    return 0;
+  }
+  switch (node -> kind) {
+  case CONSTANT_NODE:
+    return 1;
+  case LOCAL_NODE:
+    return LOCAL_DEPTH(node -> value) == 0 && !LOCAL_MUTABLE(node -> value);
+  case GLOBAL_NODE:
+    return node -> value != name;
+  case IF_NODE:
+  case BEGIN_NODE:
+  case AND_NODE:
+  case OR_NODE:
+  case COND_NODE:
+  case CALL_NODE:
+    for (int i = 0; i < node -> count; i++) {
+      if (!inlinable(node -> children[i], name, size)) {
+        return 0;
+      }
+    }
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+/* Function: copyNode
+ * --------------------
+ *   Copies the body of a lambda for a call it is inlined into, replacing
+ *   each parameter with the argument passed for it.
+ *
+ *   node: The body, or a node in it.
+ *   args: The argument of each parameter, or NULL to copy the node as it is.
+ *   returns: The copy.
+ */
+
+static Node *copyNode(Node *node, Node **args) {
+  if (node -> kind == LOCAL_NODE && args != NULL) {
+    return copyNode(args[LOCAL_SLOT(node -> value)], NULL);
+  }
+  Node *copy = makeNode(node -> kind, node -> run, node -> count, node -> source);
+  copy -> slots = node -> slots;
+  copy -> value = node -> value;
+  copy -> text = node -> text;
+  for (int i = 0; i < node -> count; i++) {
+    copy -> children[i] = copyNode(node -> children[i], args);
+  }
+  return copy;
+}
+
+/* Function: inlineCall
+ * --------------------
+ *   Replaces a call of a variable bound to a small lambda with the body of
+ *   the lambda. The lambda can't capture anything, since nothing but its
+ *   parameters would be in reach of the body, and the call has to pass
+ *   exactly as many arguments as it has parameters. Each argument has to be
+ *   a constant or a local variable that is never assigned, which is the same
+ *   whenever it is evaluated, and evaluating it can't fail, so the body can
+ *   use it in place of the parameter.
+ *
+ *   node: A CALL_NODE, whose children are already optimized.
+ *   returns: The optimized copy of the body, or the node if it can't be
+ *   inlined.
+ */
+
+static Node *inlineCall(Node *node) {
+  Node *operator = node -> children[0];
+  if (operator -> kind != GLOBAL_NODE) {
+    return node;
+  }
+  Value *function = boundFor(operator -> value);
+  if (function == NULL || TYPE(function) != CLOSURE_TYPE) {
+    return node;
+  }
+  Node *lambda = function -> cl.lambda;
+  if (lambda -> count != 1 || lambda -> slots != node -> count - 1) {
+    return node;
+  }
+  for (int i = 1; i < node -> count; i++) {
+    Node *arg = node -> children[i];
+    if (arg -> kind != CONSTANT_NODE &&
+        (arg -> kind != LOCAL_NODE || LOCAL_MUTABLE(arg -> value))) {
+      return node;
+    }
+  }
+  // The JIT, or the C compiler, may have wrapped the body in a NATIVE_NODE.
+  Node *body = lambda -> children[0];
+  if (body -> kind == NATIVE_NODE) {
+    body = body -> children[0];
+  }
+  int size = 0;
+  if (!inlinable(body, operator -> value, &size)) {
+    return node;
+  }
+  if (optReport) {
+    recordTransformation(OPT_INLINED, node -> source, operator -> value, NULL);
+  }
+  // The arguments may make more of the body constant, but what it calls
+  // isn't inlined in turn.
+  inlinedAt = node -> source;
+  Node *copy = optimize(copyNode(body, node -> children + 1), 0);
+  inlinedAt = NULL;
+  return copy;
+}
+
+/* Function: optimize
+ * --------------------
+ *   The optimizer, run over the node of a top-level expression and
+ *   everything in it, from the bottom up.
+ *
+ *   node: The node.
+ *   inlining: Whether calls are inlined.
+ *   returns: The optimized node, which may be the node itself.
+ */
+
+static Node *optimize(Node *node, int inlining) {
+  // The other children of a lambda are where its free variables are.
+  int count = node -> kind == LAMBDA_NODE ? 1 : node -> count;
+  for (int i = 0; i < count; i++) {
+    node -> children[i] = optimize(node -> children[i], inlining);
+  }
+
+  switch (node -> kind) {
+  case GLOBAL_NODE: {
+    Value *value = boundFor(node -> value);
+    if (value == NULL) {
+      return node;
+    }
+    int type = TYPE(value);
+    if (type != INT_TYPE && type != DOUBLE_TYPE && type != BOOL_TYPE &&
+        type != STR_TYPE && type != NULL_TYPE && type != CONS_TYPE) {
+      return node;
+    }
+    if (optReport) {
+      recordTransformation(OPT_PROPAGATED, optSite, node -> value, value);
+    }
+    return constantNode(value, node -> source);
+  }
+  case IF_NODE:
+    if (node -> children[0] -> kind != CONSTANT_NODE) {
+      return node;
+    }
+    if (optReport) {
+      recordTransformation(OPT_PRUNED, inlinedAt != NULL ? inlinedAt : node -> source,
+                           node -> children[0] -> value, NULL);
+    }
+    return node -> children[IS_TRUE(node -> children[0] -> value) ? 1 : 2];
+  case CALL_NODE: {
+    Node *folded = foldCall(node);
+    if (folded != node || !inlining) {
+      return folded;
+    }
+    return inlineCall(node);
+  }
+  default:
+    return node;
+  }
+}
+
+/* Function: optimizeTopLevel
+ * --------------------
+ *   Optimizes a top-level expression once it is analyzed. Does nothing
+ *   without --opt.
+ *
+ *   expr: The expression, which what the optimizer does is reported at.
+ *   node: Its node.
+ *   returns: The node to evaluate in its place.
+ */
+
+Node *optimizeTopLevel(Value *expr, Node *node) {
+  if (optMode) {
+    optSite = expr;
+    optForm += 1;
+    node = optimize(node, 1);
+  }
+  return node;
+}
+
+/* Function: describeValue
+ * --------------------
+ *   Writes out a constant for --opt-report, the way it would be printed,
+ *   with a list shortened to "(...)".
+ *
+ *   value: The constant.
+ *   buffer: Where to write the description.
+ *   size: The size of the buffer.
+ */
+
+static void describeValue(Value *value, char *buffer, size_t size) {
+  switch (TYPE(value)) {
+  case INT_TYPE:
+    snprintf(buffer, size, "%li", (long) FIXNUM_VALUE(value));
+    break;
+  case DOUBLE_TYPE:
+    snprintf(buffer, size, "%f", value -> d);
+    break;
+  case BOOL_TYPE:
+    snprintf(buffer, size, "%s", value == TRUE_VALUE ? "#t" : "#f");
+    break;
+  case STR_TYPE:
+  case SYMBOL_TYPE:
+    snprintf(buffer, size, "%s", value -> s);
+    break;
+  case NULL_TYPE:
+    snprintf(buffer, size, "()");
+    break;
+  default:
+    snprintf(buffer, size, "(...)");
+    break;
+  }
+}
+
+/* Function: printOptReport
+ * --------------------
+ *   Prints what the optimizer did to stderr: how many of each
+ *   transformation, and then each of them, with where it was.
+ */
+
+void printOptReport() {
+  int counts[OPT_INLINED + 1] = {0};
+  for (int i = 0; i < optRecordCount; i++) {
+    counts[optRecords[i].kind] += 1;
+  }
+  fprintf(stderr, "Optimizer: %d calls folded, %d branches pruned, %d variables propagated, %d calls inlined\n",
+          counts[OPT_FOLDED], counts[OPT_PRUNED], counts[OPT_PROPAGATED], counts[OPT_INLINED]);
+  for (int i = 0; i < optRecordCount; i++) {
+    struct optRecord *entry = &optRecords[i];
+    char site[128];
+    char value[64];
+    if (IS_CONS(entry -> site)) {
+      describeSite(entry -> site, site, sizeof(site));
+    }
+    else {
+      // A top-level expression that isn't a list, such as a variable, has no
+      // span, so it is located by its place in the program.
+      char atom[64];
+      describeValue(entry -> site, atom, sizeof(atom));
+      snprintf(site, sizeof(site), "expression %d (%s)", entry -> form, atom);
+    }
+    switch (entry -> kind) {
+    case OPT_FOLDED:
+      describeValue(entry -> subject, value, sizeof(value));
+      fprintf(stderr, "Optimizer: %s: folded to %s\n", site, value);
+      break;
+    case OPT_PRUNED:
+      fprintf(stderr, "Optimizer: %s: test is always %s\n", site, IS_TRUE(entry -> subject) ? "true" : "false");
+      break;
+    case OPT_PROPAGATED:
+      describeValue(entry -> value, value, sizeof(value));
+      fprintf(stderr, "Optimizer: %s: %s replaced with %s\n", site, entry -> subject -> s, value);
+      break;
+    case OPT_INLINED:
+      fprintf(stderr, "Optimizer: %s: inlined %s\n", site, entry -> subject -> s);
+      break;
+    }
+  }
+}
@@ -43,35 +43,58 @@ Value *parse(Value *tokens){
   Value *current = tokens;
   assert(current != NULL && "Error (parse): null pointer");
 
-  while (current->type != NULL_TYPE) {
-    if (car(current) -> type == OPEN_TYPE) {
+  while (TYPE(current) != NULL_TYPE) {
+    if (TYPE(car(current)) == OPEN_TYPE) {
       depth = depth + 1;
     }
 
-    if (car(current) -> type == CLOSE_TYPE) {
+    if (TYPE(car(current)) == CLOSE_TYPE) {
       if(depth == 0) {
         syntaxError();
       }
       depth = depth - 1;
     }
 
-    if (car(current) -> type != CLOSE_TYPE) {
+    if (TYPE(car(current)) != CLOSE_TYPE) {
       stack = cons(car(current), stack);
     }
 
     else {
-      Value *tempList = makeNull();
-      while (car(stack) -> type != OPEN_TYPE) {
-        if (stack -> type == NULL_TYPE) {
-          syntaxError();
-        }
-        tempList = cons(car(stack), tempList);
+      // The stack holds the elements last one first, so count them and fill
+      // a single run made by makeList from the back.
+      int count = 0;
+      Value *open = stack;
+      while (TYPE(open) != NULL_TYPE && TYPE(car(open)) != OPEN_TYPE) {
+        count = count + 1;
+        open = cdr(open);
+      }
+      if (TYPE(open) == NULL_TYPE) {
+        syntaxError();
+      }
+
+      Value **elements = talloc(sizeof(Value *) * (count + 1));
+      for (int i = count - 1; i >= 0; i--) {
+        elements[i] = car(stack);
         stack = cdr(stack);
       }
+      Value *tempList = makeList(count);
+      Value *slot = tempList;
+      for (int i = 0; i < count; i++) {
+        slot -> c.car = elements[i];
+        slot = cdr(slot);
+      }
+
+      // A list spans from its open parenthesis to its close parenthesis.
+      const struct sourceSpan *openSpan = findSpan(car(open));
+      const struct sourceSpan *closeSpan = findSpan(car(current));
+      if (openSpan != NULL && closeSpan != NULL) {
+        struct sourceSpan span = {openSpan -> line, openSpan -> column,
+                                  closeSpan -> endLine, closeSpan -> endColumn};
+        recordSpan(tempList, &span);
+      }
 
       stack = cdr(stack);
       stack = cons(tempList, stack);
-      tempList = makeNull();
     }
 
     if (depth == 0) {
@@ -103,99 +126,99 @@ Value *parse(Value *tokens){
 void printTree(Value *tree) {
   Value *cur = tree;
 
-  if (cur -> type == CONS_TYPE) {
+  if (TYPE(cur) == CONS_TYPE) {
     printf("(");
-    while (cur -> type != NULL_TYPE) {
-      if(cur -> type == CONS_TYPE){
-        if (car(cur) -> type == CONS_TYPE) {
+    while (TYPE(cur) != NULL_TYPE) {
+      if(TYPE(cur) == CONS_TYPE){
+        if (TYPE(car(cur)) == CONS_TYPE) {
           printTree(car(cur));
           cur = cdr(cur);
         }
 
-        else if (car(cur) -> type == SYMBOL_TYPE) {
+        else if (TYPE(car(cur)) == SYMBOL_TYPE) {
           printf("%s ", car(cur) -> s);
           cur = cdr(cur);
         }
 
-        else if (car(cur) -> type == INT_TYPE) {
-          printf("%i ", car(cur) -> i);
+        else if (TYPE(car(cur)) == INT_TYPE) {
+          printf("%li ", (long) FIXNUM_VALUE(car(cur)));
           cur = cdr(cur);
         }
 
-        else if (car(cur) -> type == DOUBLE_TYPE) {
+        else if (TYPE(car(cur)) == DOUBLE_TYPE) {
           printf("%f ", car(cur) -> d);
           cur = cdr(cur);
         }
 
-        else if (car(cur) -> type == STR_TYPE) {
+        else if (TYPE(car(cur)) == STR_TYPE) {
           printf("%s ", car(cur) -> s);
           cur = cdr(cur);
         }
 
-        else if (car(cur) -> type == OPEN_TYPE) {
+        else if (TYPE(car(cur)) == OPEN_TYPE) {
           printf("%s ", car(cur) -> s);
           cur = cdr(cur);
         }
 
-        else if (car(cur) -> type == CLOSE_TYPE) {
+        else if (TYPE(car(cur)) == CLOSE_TYPE) {
           printf("%s ", car(cur) -> s);
           cur = cdr(cur);
         }
 
-        else if (car(cur) -> type == BOOL_TYPE) {
-          printf("%s ", car(cur) -> s);
+        else if (TYPE(car(cur)) == BOOL_TYPE) {
+          printf("%s ", car(cur) == TRUE_VALUE ? "#t" : "#f");
           cur = cdr(cur);
         }
-        else if (car(cur) -> type == NULL_TYPE) {
+        else if (TYPE(car(cur)) == NULL_TYPE) {
           printf("() ");
           cur = cdr(cur);
         }
 
-        if(cur -> type != CONS_TYPE && cur -> type != NULL_TYPE){
+        if(TYPE(cur) != CONS_TYPE && TYPE(cur) != NULL_TYPE){
           printf(". ");
         }
       }
       else{
-        if (cur -> type == CONS_TYPE) {
+        if (TYPE(cur) == CONS_TYPE) {
           printTree(car(cur));
           cur = cdr(cur);
         }
 
-        else if (cur -> type == SYMBOL_TYPE) {
+        else if (TYPE(cur) == SYMBOL_TYPE) {
           printf("%s", cur -> s);
           break;
         }
 
-        else if (cur -> type == INT_TYPE) {
-          printf("%i", cur -> i);
+        else if (TYPE(cur) == INT_TYPE) {
+          printf("%li", (long) FIXNUM_VALUE(cur));
           break;
         }
 
-        else if (cur -> type == DOUBLE_TYPE) {
+        else if (TYPE(cur) == DOUBLE_TYPE) {
           printf("%f", cur -> d);
           break;
         }
 
-        else if (cur -> type == STR_TYPE) {
+        else if (TYPE(cur) == STR_TYPE) {
           printf("%s", cur -> s);
           break;
         }
 
-        else if (cur -> type == OPEN_TYPE) {
+        else if (TYPE(cur) == OPEN_TYPE) {
           printf("%s", cur -> s);
           break;
         }
 
-        else if (cur -> type == CLOSE_TYPE) {
+        else if (TYPE(cur) == CLOSE_TYPE) {
           printf("%s", cur -> s);
           break;
         }
 
-        else if (cur -> type == BOOL_TYPE) {
-          printf("%s", cur -> s);
+        else if (TYPE(cur) == BOOL_TYPE) {
+          printf("%s", cur == TRUE_VALUE ? "#t" : "#f");
           break;
         }
-        else if (cur -> type == NULL_TYPE) {
+        else if (TYPE(cur) == NULL_TYPE) {
           printf("()");
           break;
         }
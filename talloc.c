@@ -1,55 +1,1520 @@
 /* talloc.c
  * Author: Khalid Hussain
  * --------------------
- * This program is a replacement for malloc that stores the pointers allocated
- * in a linked list.
+ * This program is a replacement for malloc that hands out memory from large
+ * chunks with a bump pointer. Chunks are kept in a linked list, so that every
+ * pointer allocated can be released at once by freeing the chunks themselves.
+ *
+ * Every pointer handed out is preceded by a small header recording its size
+ * and kind, which lets a precise mark-and-sweep garbage collector reclaim
+ * Values, Frames and strings that are no longer reachable from the roots: the
+ * global frame, the parse tree and the slots protected by the evaluator while
+ * it runs. Reclaimed pointers are kept on free lists, binned by size, and are
+ * handed out again before the bump pointer is used.
+ *
+ * In region mode, pointers allocated while a region is open are bumped from
+ * chunks of their own. When the region is closed, only the pointers that
+ * escaped it, through a write recorded by gcWriteBarrier, are copied out into
+ * the heap, and the chunks of the region are recycled whole.
  */
 
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
 #include <assert.h>
 #include "headers/linkedlist.h"
 #include "headers/value.h"
 #include "headers/talloc.h"
 
-struct node *globallist = NULL; // global linked list of pointers
+#define CHUNK_SIZE (1 << 20)            // usable bytes in a regular chunk
+#define LARGE_ALLOC (CHUNK_SIZE / 4)    // anything bigger gets its own chunk
+#define GRANULE 8                       // every size is rounded up to this
+#define SMALL_GRANULES 32               // free lists binned exactly up to here
+
+struct chunk *chunklist = NULL;         // global linked list of chunks
+static struct chunk *current = NULL;    // chunk that the bump pointer is in
+
+// Chunks of the open region, the one its bump pointer is in, and empty chunks
+// kept around to be reused by the next region.
+static struct chunk *regionlist = NULL;
+static struct chunk *regionCurrent = NULL;
+static struct chunk *sparelist = NULL;
+static int regionOpen = 0;
+#define MAX_SPARE_CHUNKS 4
+
+// Chunks of the frame stack, the one its top is in first. Pointers on it are
+// released in the opposite order they were handed out, by stackRelease.
+static struct chunk *stacklist = NULL;
+static size_t stackBytes = 0;           // bytes in use on the frame stack
+static size_t peakStackBytes = 0;       // the most that ever were
+
+// Pointers that are never reclaimed nor moved, such as interned symbols, are
+// bumped from their own chunks. They stay marked, so the collector never
+// traces past them.
+static struct chunk *permanentlist = NULL;
+
+// bins[n] holds free pointers of exactly n granules; bins[0] holds the larger
+// ones, to be split on demand.
+static struct header *bins[SMALL_GRANULES + 1];
+
+// Roots: permanent ones registered once, and the stack of slots protected by
+// the evaluator while it runs.
+static void ***roots = NULL;
+static int rootCount = 0;
+static int rootCapacity = 0;
+static void ***protected = NULL;
+static int protectedCount = 0;
+static int protectedCapacity = 0;
+
+// The functions that drop the dead entries of weak tables, called between
+// marking and sweeping.
+static void (**weakTables)() = NULL;
+static int weakTableCount = 0;
+static int weakTableCapacity = 0;
+
+// Pointers that have been marked but whose children haven't been, so that
+// marking long lists doesn't recurse once per cons cell.
+static void **markStack = NULL;
+static int markCount = 0;
+static int markCapacity = 0;
+
+// Pointers in the open region that were written into pointers outside of it.
+static void **remembered = NULL;
+static int rememberedCount = 0;
+static int rememberedCapacity = 0;
+
+// Heap-growth policy: collect once the bytes in use pass the threshold, then
+// set the threshold to the bytes that survived times the growth factor, but
+// never below the minimum heap size.
+static int gcEnabled = 1;
+static size_t gcMinHeap = 4 << 20;
+static double gcGrowth = 2.0;
+static size_t gcThreshold = 4 << 20;
+static size_t bytesInUse = 0;
+static size_t peakBytesInUse = 0;
+
+// What has been handed out, for each type of Value plus Frames and raw bytes.
+// The live counts are rebuilt by each sweep, like bytesInUse.
+static struct memoryCounter counters[MEMORY_COUNTERS];
+
+// The heap profiler: what was allocated at each site, in the order the sites
+// were first seen, with an open-addressed table of indexes into it (plus one,
+// so that 0 is an empty slot) to find a site again. The last site looked up is
+// remembered, since most allocations come in runs from the same one.
+static int profiling = 0;
+static void *profileSite = NULL;
+static struct siteCounter *sites = NULL;
+static int siteCount = 0;
+static int siteCapacity = 0;
+static int *siteIndex = NULL;
+static int siteIndexCapacity = 0;
+static int lastSite = -1;
+
+static struct {
+  long collections;
+  double totalPause;
+  double maxPause;
+  size_t bytesReclaimed;
+  size_t bytesAllocated;
+  size_t liveAfterLast;
+  size_t heapSize;
+  size_t peakHeapSize;
+  long regions;
+  size_t regionBytesReclaimed;
+  size_t regionBytesPromoted;
+} stats;
+
+/* Function: growArray
+ * --------------------
+ *   Grows one of the malloc'd arrays used by the collector itself, which can't
+ *   use talloc since they have to survive collections.
+ *
+ *   array: The array to grow.
+ *   capacity: The current capacity of the array, updated in place.
+ *   elementSize: The size of a single element of the array.
+ *   returns: The grown array.
+ */
+
+static void *growArray(void *array, int *capacity, size_t elementSize) {
+  int newCapacity = *capacity == 0 ? 256 : *capacity * 2;
+  void *newArray = realloc(array, newCapacity * elementSize);
+  if (newArray == NULL) {
+    printf("Memory error: out of memory. \n");
+    texit(1);
+  }
+  *capacity = newCapacity;
+  return newArray;
+}
+
+/* Function: newChunk
+ * --------------------
+ *   Mallocs a new chunk able to hold at least size bytes, or reuses a spare
+ *   one, and pushes it onto the given list of chunks.
+ *
+ *   size: The number of usable bytes the chunk must hold.
+ *   list: The list of chunks to push it onto.
+ *   returns: The new chunk.
+ */
+
+static struct chunk *newChunk(size_t size, struct chunk **list) {
+  struct chunk *chunk;
+  if (size == CHUNK_SIZE && sparelist != NULL) {
+    chunk = sparelist;
+    sparelist = chunk -> next;
+  }
+  else {
+    chunk = malloc(sizeof(struct chunk) + size);
+    if (chunk == NULL) {
+      printf("Memory error: out of memory. \n");
+      texit(1);
+    }
+    chunk -> limit = chunk -> data + size;
+    stats.heapSize += size;
+    if (stats.heapSize > stats.peakHeapSize) {
+      stats.peakHeapSize = stats.heapSize;
+    }
+  }
+  chunk -> top = chunk -> data;
+  chunk -> next = *list;
+  *list = chunk;
+  return chunk;
+}
+
+/* Function: releaseChunk
+ * --------------------
+ *   Gives a chunk that holds nothing live back to the system, or keeps it as a
+ *   spare if it is a regular one and there aren't many spares yet.
+ *
+ *   chunk: The chunk to release, already unlinked from its list.
+ */
+
+static void releaseChunk(struct chunk *chunk) {
+  int spares = 0;
+  for (struct chunk *spare = sparelist; spare != NULL; spare = spare -> next) {
+    spares++;
+  }
+  if (chunk -> limit - chunk -> data == CHUNK_SIZE && spares < MAX_SPARE_CHUNKS) {
+    chunk -> next = sparelist;
+    sparelist = chunk;
+  }
+  else {
+    stats.heapSize -= chunk -> limit - chunk -> data;
+    free(chunk);
+  }
+}
+
+/* Function: binFor
+ * --------------------
+ *   Finds the free list that a free pointer of the given size belongs in.
+ *
+ *   size: The size of the free pointer, in bytes.
+ *   returns: The index of the bin.
+ */
+
+static int binFor(size_t size) {
+  size_t granules = size / GRANULE;
+  return granules <= SMALL_GRANULES ? (int) granules : 0;
+}
+
+/* Function: pushFree
+ * --------------------
+ *   Turns the given header into a free pointer and pushes it onto its bin.
+ *   Free pointers too small to hold the link are left out of the bins; they
+ *   are merged back with their neighbours at the next collection.
+ *
+ *   header: The header of the free pointer.
+ *   size: The size of the free pointer, not counting its header.
+ */
+
+static void pushFree(struct header *header, size_t size) {
+  header -> size = size;
+  header -> kind = FREE_KIND;
+  header -> mark = 0;
+  if (size >= sizeof(struct header *)) {
+    int bin = binFor(size);
+    *(struct header **)(header + 1) = bins[bin];
+    bins[bin] = header;
+  }
+}
+
+/* Function: takeFree
+ * --------------------
+ *   Finds a free pointer of at least the given size, looking through the
+ *   larger bins first-fit, and splits off whatever is left over.
+ *
+ *   size: The size needed, a multiple of the granule.
+ *   returns: The header of the free pointer, or NULL if there is none.
+ */
+
+static struct header *takeFree(size_t size) {
+  int first = binFor(size) == 0 ? SMALL_GRANULES + 1 : binFor(size) + 1;
+  for (int bin = first; bin <= SMALL_GRANULES + 1; bin++) {
+    struct header **link = &bins[bin == SMALL_GRANULES + 1 ? 0 : bin];
+    while (*link != NULL) {
+      struct header *header = *link;
+      if (header -> size == size || header -> size >= size + sizeof(struct header)) {
+        *link = *(struct header **)(header + 1);
+        if (header -> size > size) {
+          struct header *rest = (struct header *)((char *)(header + 1) + size);
+          pushFree(rest, header -> size - size - sizeof(struct header));
+        }
+        header -> size = size;
+        return header;
+      }
+      link = (struct header **)(header + 1);
+    }
+  }
+  return NULL;
+}
+
+/* Function: bump
+ * --------------------
+ *   Bumps a pointer of the given size from the top of a chunk.
+ *
+ *   chunk: The chunk to bump the pointer from.
+ *   size: The size needed, a multiple of the granule.
+ *   returns: The header of the new pointer, or NULL if the chunk is full.
+ */
+
+static struct header *bump(struct chunk *chunk, size_t size) {
+  if (chunk == NULL || chunk -> top + sizeof(struct header) + size > chunk -> limit) {
+    return NULL;
+  }
+  struct header *header = (struct header *) chunk -> top;
+  chunk -> top += sizeof(struct header) + size;
+  header -> size = size;
+  return header;
+}
+
+/* Function: objectSize
+ * --------------------
+ *   Works out the size of what follows a header. That's the size in the
+ *   header, except for a cell of a run made by tallocList, which only holds its
+ *   car and uses the size in its header for something else.
+ *
+ *   header: The header.
+ *   returns: The number of bytes between it and the next header.
+ */
+
+static size_t objectSize(struct header *header) {
+  if (header -> kind != FREE_KIND && (header -> flags & CDR_NEXT_FLAG)) {
+    return sizeof(Value *);
+  }
+  return header -> size;
+}
+
+/* Function: counterFor
+ * --------------------
+ *   Picks the memory counter that a pointer is counted under.
+ *
+ *   header: The header of the pointer.
+ *   returns: Its type if it is a Value, or FRAME_COUNTER or RAW_COUNTER.
+ */
+
+static int counterFor(struct header *header) {
+  if (header -> kind == VALUE_KIND) {
+    return header -> type;
+  }
+  return header -> kind == FRAME_KIND ? FRAME_COUNTER : RAW_COUNTER;
+}
+
+/* Function: countLive
+ * --------------------
+ *   Adds a pointer to the live counts, or takes it away from them.
+ *
+ *   header: The header of the pointer.
+ *   sign: 1 to add it, -1 to take it away.
+ */
+
+static void countLive(struct header *header, int sign) {
+  struct memoryCounter *counter = &counters[counterFor(header)];
+  counter -> liveObjects += sign;
+  counter -> liveBytes += sign * (long) (sizeof(struct header) + objectSize(header));
+}
+
+/* Function: allocate
+ * --------------------
+ *   Finds room for a pointer of a given kind. A free pointer of exactly the
+ *   right size is reused if there is one; otherwise the pointer of the current
+ *   chunk is bumped, and only once that is full are larger free pointers split
+ *   or a new chunk started. Large requests are given a chunk of their own, so
+ *   that they don't waste the current chunk. The pointer is counted as live,
+ *   but not as allocated, since copies made by regionEnd go through here too.
+ *
+ *   size: The size of the pointer that needs to be allocated.
+ *   kind: What the pointer will hold, so the collector knows how to trace it.
+ *   type: The type stored in the header, for a Value.
+ *   returns: The header of the pointer that was allocated.
+ */
+
+static struct header *allocate(size_t size, allocKind kind, valueType type) {
+  size = size == 0 ? GRANULE : (size + GRANULE - 1) & ~(size_t)(GRANULE - 1);
+  struct header *header = NULL;
+  int bin = binFor(size);
+
+  if (regionOpen) {
+    header = size > LARGE_ALLOC ? NULL : bump(regionCurrent, size);
+    if (header == NULL) {
+      struct chunk *chunk = newChunk(size > LARGE_ALLOC ? size + sizeof(struct header) : CHUNK_SIZE, &regionlist);
+      if (size <= LARGE_ALLOC) {
+        regionCurrent = chunk;
+      }
+      header = bump(chunk, size);
+    }
+  }
+  else if (bin != 0 && bins[bin] != NULL) {
+    header = bins[bin];
+    bins[bin] = *(struct header **)(header + 1);
+  }
+  else if (size > LARGE_ALLOC) {
+    header = takeFree(size);
+    if (header == NULL) {
+      struct chunk *chunk = newChunk(size + sizeof(struct header), &chunklist);
+      header = bump(chunk, size);
+    }
+  }
+  else {
+    header = bump(current, size);
+    if (header == NULL) {
+      header = takeFree(size);
+    }
+    if (header == NULL) {
+      current = newChunk(CHUNK_SIZE, &chunklist);
+      header = bump(current, size);
+    }
+  }
+
+  header -> kind = kind;
+  header -> mark = 0;
+  header -> flags = regionOpen ? REGION_FLAG : 0;
+  header -> type = type;
+  bytesInUse += sizeof(struct header) + size;
+  stats.bytesAllocated += sizeof(struct header) + size;
+  if (bytesInUse > peakBytesInUse) {
+    peakBytesInUse = bytesInUse;
+  }
+  countLive(header, 1);
+  return header;
+}
+
+/* Function: siteHash
+ * --------------------
+ *   Hashes the address of an allocation site into the table of sites.
+ *
+ *   site: The site.
+ *   returns: The slot to start looking for it at.
+ */
+
+static int siteHash(void *site) {
+  uintptr_t h = (uintptr_t) site;
+  h ^= h >> 17;
+  h *= 0x9E3779B97F4A7C15ull;
+  return (int) (h >> 32) & (siteIndexCapacity - 1);
+}
+
+/* Function: findSite
+ * --------------------
+ *   Finds the counter of the current allocation site, adding one if the site
+ *   hasn't allocated anything yet. The table of indexes is doubled whenever it
+ *   gets half full.
+ *
+ *   returns: The index of the counter in sites.
+ */
+
+static int findSite() {
+  if (lastSite >= 0 && sites[lastSite].site == profileSite) {
+    return lastSite;
+  }
+  if (siteIndexCapacity == 0 || 2 * (siteCount + 1) > siteIndexCapacity) {
+    free(siteIndex);
+    siteIndexCapacity = siteIndexCapacity == 0 ? 256 : siteIndexCapacity * 2;
+    siteIndex = calloc(siteIndexCapacity, sizeof(int));
+    if (siteIndex == NULL) {
+      printf("Memory error: out of memory. \n");
+      texit(1);
+    }
+    for (int i = 0; i < siteCount; i++) {
+      int slot = siteHash(sites[i].site);
+      while (siteIndex[slot] != 0) {
+        slot = (slot + 1) & (siteIndexCapacity - 1);
+      }
+      siteIndex[slot] = i + 1;
+    }
+  }
+
+  int slot = siteHash(profileSite);
+  while (siteIndex[slot] != 0 && sites[siteIndex[slot] - 1].site != profileSite) {
+    slot = (slot + 1) & (siteIndexCapacity - 1);
+  }
+  if (siteIndex[slot] == 0) {
+    if (siteCount == siteCapacity) {
+      sites = growArray(sites, &siteCapacity, sizeof(struct siteCounter));
+    }
+    sites[siteCount].site = profileSite;
+    sites[siteCount].objects = 0;
+    sites[siteCount].bytes = 0;
+    siteIndex[slot] = ++siteCount;
+  }
+  lastSite = siteIndex[slot] - 1;
+  return lastSite;
+}
+
+/* Function: profileCount
+ * --------------------
+ *   Charges an allocation to the current allocation site.
+ *
+ *   objects: The number of objects allocated.
+ *   bytes: Their size, headers included.
+ */
+
+static void profileCount(size_t objects, size_t bytes) {
+  int index = findSite();
+  struct siteCounter *counter = &sites[index];
+  counter -> objects += objects;
+  counter -> bytes += bytes;
+}
+
+/* Function: countAllocated
+ * --------------------
+ *   Counts a pointer that was just handed out by talloc.
+ *
+ *   header: The header of the pointer.
+ */
+
+static void countAllocated(struct header *header) {
+  struct memoryCounter *counter = &counters[counterFor(header)];
+  counter -> allocatedObjects++;
+  counter -> allocatedBytes += sizeof(struct header) + objectSize(header);
+  if (profiling) {
+    profileCount(1, sizeof(struct header) + objectSize(header));
+  }
+}
+
+/* Function: tallocKind
+ * --------------------
+ *   Function that performs the talloc for a pointer of a given kind.
+ *
+ *   size: The size of the pointer that needs to be allocated.
+ *   kind: What the pointer will hold, so the collector knows how to trace it.
+ *   returns: The pointer that was allocated
+ */
+
+void *tallocKind(size_t size, allocKind kind) {
+  struct header *header = allocate(size, kind, NULL_TYPE);
+  countAllocated(header);
+  return header + 1;
+}
 
 /* Function: talloc
  * --------------------
- *   Function that performs the talloc by storing a pointer, malloc'd for a
- *   particular size, in a linked list.
+ *   Function that performs the talloc for a pointer holding raw bytes, such as
+ *   a string, that the collector doesn't need to look inside of.
  *
- *   size: The size of the pointer that needs to be malloc'd.
- *   returns: The pointer that was malloc'd
+ *   size: The size of the pointer that needs to be allocated.
+ *   returns: The pointer that was allocated
  */
 
 void *talloc(size_t size){
-  struct node *link = (struct node*) malloc(sizeof(struct node));
-  void *pointer = malloc(size);
+  return tallocKind(size, RAW_KIND);
+}
+
+/* Function: valueSize
+ * --------------------
+ *   Works out how many bytes a Value of the given type needs. Only the union
+ *   member that the type uses is allocated, so a double takes one word rather
+ *   than the four a symbol needs.
+ *
+ *   type: The type of the Value.
+ *   returns: The size of its payload in bytes.
+ */
+
+static size_t valueSize(valueType type) {
+  switch (type) {
+    case CONS_TYPE:
+      return sizeof(struct ConsCell);
+    case CLOSURE_TYPE:
+      return sizeof(struct Closure);
+    case SYMBOL_TYPE:
+      return sizeof(struct Symbol);
+    case PRIMITIVE_TYPE:
+      return sizeof(struct Primitive);
+    case DOUBLE_TYPE:
+      return sizeof(double);
+    default:
+      return sizeof(void *);
+  }
+}
+
+/* Function: tallocValue
+ * --------------------
+ *   Allocates a Value struct of the given type that the collector knows how to
+ *   trace. The type is kept in the header in front of it rather than in the
+ *   struct, and the payload is zeroed so it is safe to trace before it is
+ *   filled in.
+ *
+ *   type: The type of the Value, which can't be one of the immediate types.
+ *   returns: The new Value struct.
+ */
+
+Value *tallocValue(valueType type) {
+  assert(type != INT_TYPE && type != NULL_TYPE && type != BOOL_TYPE &&
+         type != VOID_TYPE && type != LOCAL_TYPE && type != UNSPECIFIED_TYPE && "Error (tallocValue): immediate type");
+  size_t size = valueSize(type);
+  struct header *header = allocate(size, VALUE_KIND, type);
+  countAllocated(header);
+  Value *value = (Value *) (header + 1);
+  memset(value, 0, size);
+  return value;
+}
+
+/* Function: tallocList
+ * --------------------
+ *   Allocates a proper list of the given length as one contiguous, cdr-coded
+ *   run of cons cells. Every cell but the last holds only its car, and is
+ *   flagged with CDR_NEXT_FLAG, meaning its cdr is the cell right after it; the
+ *   size in its header holds the number of cells after it in the run instead,
+ *   so the length of the run can be read off any cell. The last cell is an
+ *   ordinary cons cell ending the list. Each cell still has its own header, so
+ *   the collector can reclaim the front of a run whose tail is still in use.
+ *
+ *   count: The length of the list, at least 1.
+ *   returns: The first cell, with every car and the final cdr the empty list.
+ */
+
+Value *tallocList(int count) {
+  assert(count > 0 && "Error (tallocList): empty list");
+  size_t cell = sizeof(struct header) + sizeof(Value *);
+  struct header *header = allocate((count - 1) * cell + sizeof(struct ConsCell), VALUE_KIND, CONS_TYPE);
+  countAllocated(header);
+  counters[CONS_TYPE].liveObjects += count - 1;
+  counters[CONS_TYPE].allocatedObjects += count - 1;
+  if (profiling) {
+    profileCount(count - 1, 0);
+  }
+
+  unsigned char flags = header -> flags;
+  char *p = (char *) header;
+  for (int i = 0; i < count; i++, p += cell) {
+    struct header *cellHeader = (struct header *) p;
+    cellHeader -> kind = VALUE_KIND;
+    cellHeader -> mark = 0;
+    cellHeader -> type = CONS_TYPE;
+    Value *value = (Value *) (cellHeader + 1);
+    value -> c.car = NULL_VALUE;
+    if (i < count - 1) {
+      cellHeader -> size = count - 1 - i;
+      cellHeader -> flags = flags | CDR_NEXT_FLAG;
+    }
+    else {
+      cellHeader -> size = sizeof(struct ConsCell);
+      cellHeader -> flags = flags;
+      value -> c.cdr = NULL_VALUE;
+    }
+  }
+  return (Value *) (header + 1);
+}
+
+/* Function: initFrame
+ * --------------------
+ *   Fills in a Frame struct that was just allocated, so that it is safe to
+ *   trace before its slots are set.
+ *
+ *   frame: The Frame struct.
+ *   size: Its number of slots.
+ *   returns: The Frame struct, with no parent and every slot the empty list.
+ */
+
+static Frame *initFrame(Frame *frame, int size) {
+  frame -> parent = NULL;
+  frame -> size = size;
+  for (int i = 0; i < size; i++) {
+    frame -> slots[i] = NULL_VALUE;
+  }
+  return frame;
+}
+
+/* Function: tallocFrame
+ * --------------------
+ *   Allocates a Frame struct that the collector knows how to trace, with the
+ *   given number of slots.
+ *
+ *   size: The number of slots.
+ *   returns: The new Frame struct, with no parent and every slot the empty list.
+ */
+
+Frame *tallocFrame(int size) {
+  return initFrame(tallocKind(sizeof(Frame) + size * sizeof(Value *), FRAME_KIND), size);
+}
+
+/* Function: stackAllocate
+ * --------------------
+ *   Bumps the top of the frame stack, starting a new chunk once the one it is
+ *   in is full.
+ *
+ *   size: The size of the pointer that needs to be allocated.
+ *   kind: What the pointer will hold, so the collector knows how to trace it.
+ *   type: The type stored in the header, for a Value.
+ *   returns: The header of the pointer that was allocated.
+ */
+
+static struct header *stackAllocate(size_t size, allocKind kind, valueType type) {
+  struct header *header = bump(stacklist, size);
+  if (header == NULL) {
+    header = bump(newChunk(CHUNK_SIZE, &stacklist), size);
+  }
+  header -> kind = kind;
+  header -> mark = 0;
+  header -> flags = STACK_FLAG;
+  header -> type = type;
+  countAllocated(header);
+  stackBytes += sizeof(struct header) + size;
+  if (stackBytes > peakStackBytes) {
+    peakStackBytes = stackBytes;
+  }
+  return header;
+}
+
+/* Function: tallocStackFrame
+ * --------------------
+ *   Same as tallocFrame, but the Frame struct is put on the frame stack, and is
+ *   gone once the stack is released past it.
+ *
+ *   size: The number of slots.
+ *   returns: The new Frame struct.
+ */
+
+Frame *tallocStackFrame(int size) {
+  size_t bytes = sizeof(Frame) + size * sizeof(Value *);
+  return initFrame((Frame *) (stackAllocate(bytes, FRAME_KIND, NULL_TYPE) + 1), size);
+}
+
+/* Function: stackMark
+ * --------------------
+ *   Remembers the top of the frame stack, to release everything put on it
+ *   afterwards with stackRelease.
+ *
+ *   returns: The top of the frame stack.
+ */
+
+void *stackMark() {
+  return stacklist == NULL ? NULL : stacklist -> top;
+}
+
+/* Function: stackRelease
+ * --------------------
+ *   Releases everything put on the frame stack since the matching stackMark,
+ *   giving back any chunks that were started in the meantime.
+ *
+ *   mark: The top of the frame stack returned by stackMark.
+ */
+
+void stackRelease(void *mark) {
+  char *top = mark;
+  while (stacklist != NULL && !(top >= stacklist -> data && top <= stacklist -> top)) {
+    struct chunk *chunk = stacklist;
+    stackBytes -= chunk -> top - chunk -> data;
+    stacklist = chunk -> next;
+    releaseChunk(chunk);
+  }
+  if (stacklist != NULL) {
+    stackBytes -= stacklist -> top - top;
+    stacklist -> top = top;
+  }
+}
+
+/* Function: stackMoveFrame
+ * --------------------
+ *   Moves the last frame put on the frame stack down to a mark, releasing
+ *   everything put on the stack between the two. A frame made for a tail call
+ *   takes the place of the frames it replaces this way, so a loop runs in the
+ *   same stack space. The frame isn't counted as allocated again.
+ *
+ *   frame: The frame, which nothing may have been put on the stack after.
+ *   mark: The top of the frame stack returned by stackMark, from before the
+ *   frame was made.
+ *   returns: The frame, where it is now.
+ */
+
+Frame *stackMoveFrame(Frame *frame, void *mark) {
+  struct header *header = (struct header *) frame - 1;
+  size_t bytes = sizeof(struct header) + header -> size;
+  char *top = mark;
+  if (top == (char *) header) {
+    return frame;
+  }
+  if (top >= stacklist -> data && top < (char *) header) {
+    memmove(top, header, bytes);
+    stackBytes -= stacklist -> top - (top + bytes);
+    stacklist -> top = top + bytes;
+    return (Frame *) ((struct header *) top + 1);
+  }
+
+  // The frame is in a chunk started after the mark, which gets given back.
+  struct header *copy = malloc(bytes);
+  if (copy == NULL) {
+    printf("Memory error: out of memory. \n");
+    texit(1);
+  }
+  memcpy(copy, header, bytes);
+  stackRelease(mark);
+  header = bump(stacklist, copy -> size);
+  if (header == NULL) {
+    header = bump(newChunk(CHUNK_SIZE, &stacklist), copy -> size);
+  }
+  memcpy(header, copy, bytes);
+  stackBytes += bytes;
+  free(copy);
+  return (Frame *) (header + 1);
+}
 
-  link->data = pointer;
-  link->next = globallist;
-  globallist = link;
+/* Function: permanentAllocate
+ * --------------------
+ *   Bumps a pointer that lives until tfree from the permanent chunks. It is
+ *   counted as allocated, but never as live, like the frame stack.
+ *
+ *   size: The size of the pointer that needs to be allocated.
+ *   kind: What the pointer will hold.
+ *   type: The type stored in the header, for a Value.
+ *   returns: The header of the pointer that was allocated.
+ */
+
+static struct header *permanentAllocate(size_t size, allocKind kind, valueType type) {
+  size = size == 0 ? GRANULE : (size + GRANULE - 1) & ~(size_t)(GRANULE - 1);
+  struct header *header = bump(permanentlist, size);
+  if (header == NULL) {
+    header = bump(newChunk(size > LARGE_ALLOC ? size + sizeof(struct header) : CHUNK_SIZE, &permanentlist), size);
+  }
+  header -> kind = kind;
+  header -> mark = 1;
+  header -> flags = 0;
+  header -> type = type;
+  countAllocated(header);
+  return header;
+}
+
+/* Function: tallocPermanent
+ * --------------------
+ *   Same as talloc, but the pointer is never reclaimed.
+ *
+ *   size: The size of the pointer that needs to be allocated.
+ *   returns: The pointer that was allocated.
+ */
 
-  return pointer;
+void *tallocPermanent(size_t size) {
+  return permanentAllocate(size, RAW_KIND, NULL_TYPE) + 1;
+}
+
+/* Function: tallocPermanentValue
+ * --------------------
+ *   Same as tallocValue, but the Value struct is never reclaimed.
+ *
+ *   type: The type of the Value, which can't be one of the immediate types.
+ *   returns: The new Value struct.
+ */
+
+Value *tallocPermanentValue(valueType type) {
+  size_t size = valueSize(type);
+  Value *value = (Value *) (permanentAllocate(size, VALUE_KIND, type) + 1);
+  memset(value, 0, size);
+  return value;
+}
+
+/* Function: gcAddRoot
+ * --------------------
+ *   Registers a global variable whose pointer must survive every collection.
+ *
+ *   slot: The address of the variable.
+ */
+
+void gcAddRoot(void *slot) {
+  if (rootCount == rootCapacity) {
+    roots = growArray(roots, &rootCapacity, sizeof(void **));
+  }
+  roots[rootCount++] = slot;
+}
+
+/* Function: gcAddWeakTable
+ * --------------------
+ *   Registers a table that holds pointers without keeping them alive. Every
+ *   collection calls its prune function once everything reachable is marked,
+ *   so that it can drop the pointers gcIsLive says are about to be
+ *   reclaimed, before their memory is handed out again.
+ *
+ *   prune: The function that drops the dead entries of the table. It must
+ *   not allocate.
+ */
+
+void gcAddWeakTable(void (*prune)()) {
+  if (weakTableCount == weakTableCapacity) {
+    weakTables = growArray(weakTables, &weakTableCapacity, sizeof(void (*)()));
+  }
+  weakTables[weakTableCount++] = prune;
+}
+
+/* Function: gcIsLive
+ * --------------------
+ *   Tells whether a pointer survives the collection in progress. Only
+ *   meaningful while a weak table is being pruned.
+ *
+ *   pointer: The pointer, which may be an immediate.
+ *   returns: 1 if it was marked, is permanent or is an immediate, 0 otherwise.
+ */
+
+int gcIsLive(void *pointer) {
+  if (pointer == NULL || !IS_POINTER(pointer)) {
+    return 1;
+  }
+  return ((struct header *) pointer - 1) -> mark;
+}
+
+/* Function: gcProtect
+ * --------------------
+ *   Pushes the address of a local variable onto the stack of protected slots,
+ *   so that whatever pointer it holds survives collections until it is popped
+ *   again by gcUnprotect.
+ *
+ *   slot: The address of the local variable.
+ */
+
+void gcProtect(void *slot) {
+  if (protectedCount == protectedCapacity) {
+    protected = growArray(protected, &protectedCapacity, sizeof(void **));
+  }
+  protected[protectedCount++] = slot;
+}
+
+/* Function: gcUnprotect
+ * --------------------
+ *   Pops slots that were pushed by gcProtect.
+ *
+ *   count: The number of slots to pop.
+ */
+
+void gcUnprotect(int count) {
+  assert(count <= protectedCount && "Error (gcUnprotect): too many slots popped");
+  protectedCount -= count;
+}
+
+/* Function: visitFields
+ * --------------------
+ *   Calls visit on the address of every pointer held by a pointer that talloc
+ *   handed out: the fields of a Value struct according to its type, or the
+ *   fields of a Frame struct. Raw bytes hold no pointers.
+ *
+ *   pointer: The pointer whose fields are visited.
+ *   visit: The function to call on the address of each field.
+ */
+
+static void visitFields(void *pointer, void (*visit)(void **field)) {
+  struct header *header = (struct header *) pointer - 1;
+  if (header -> kind == VALUE_KIND) {
+    Value *value = pointer;
+    switch (header -> type) {
+      case CONS_TYPE:
+        visit((void **) &value -> c.car);
+        if (header -> flags & CDR_NEXT_FLAG) {
+          // The next cell of a run isn't pointed to by a field, but it is the
+          // cdr, so it has to be kept all the same. Runs are never in a region
+          // while anything outside of it is, so it never needs fixing up.
+          void *next = (char *) pointer + sizeof(struct header) + sizeof(Value *);
+          visit(&next);
+        }
+        else {
+          visit((void **) &value -> c.cdr);
+        }
+        break;
+      case STR_TYPE:
+      case SYMBOL_TYPE:
+      case OPEN_TYPE:
+      case CLOSE_TYPE:
+        visit((void **) &value -> s);
+        break;
+      case CLOSURE_TYPE:
+        // The lambda is permanent, so only the frame is traced.
+        visit((void **) &value -> cl.frame);
+        break;
+      default:
+        break;
+    }
+  }
+  else if (header -> kind == FRAME_KIND) {
+    Frame *frame = pointer;
+    visit((void **) &frame -> parent);
+    for (int i = 0; i < frame -> size; i++) {
+      visit((void **) &frame -> slots[i]);
+    }
+  }
+}
+
+/* Function: markPointer
+ * --------------------
+ *   Marks a pointer as reachable. Pointers that hold other pointers are pushed
+ *   onto the mark stack so their children get marked as well.
+ *
+ *   pointer: The pointer to mark, which may be NULL or an immediate.
+ */
+
+static void markPointer(void *pointer) {
+  if (pointer == NULL || !IS_POINTER(pointer)) {
+    return;
+  }
+  struct header *header = (struct header *) pointer - 1;
+  if (header -> mark) {
+    return;
+  }
+  header -> mark = 1;
+  if (header -> kind != RAW_KIND) {
+    if (markCount == markCapacity) {
+      markStack = growArray(markStack, &markCapacity, sizeof(void *));
+    }
+    markStack[markCount++] = pointer;
+  }
+}
+
+/* Function: markField
+ * --------------------
+ *   Marks the pointer held in a field.
+ *
+ *   field: The address of the field.
+ */
+
+static void markField(void **field) {
+  markPointer(*field);
+}
+
+/* Function: traceMarked
+ * --------------------
+ *   Marks the children of everything on the mark stack, until it is empty.
+ */
+
+static void traceMarked() {
+  while (markCount > 0) {
+    visitFields(markStack[--markCount], markField);
+  }
+}
+
+/* Function: mark
+ * --------------------
+ *   Marks everything reachable from the roots and the protected slots.
+ */
+
+static void mark() {
+  for (int i = 0; i < rootCount; i++) {
+    markPointer(*roots[i]);
+  }
+  for (int i = 0; i < protectedCount; i++) {
+    markPointer(*protected[i]);
+  }
+  traceMarked();
+}
+
+/* Function: sweepChunk
+ * --------------------
+ *   Walks a chunk, clearing the marks and region flags of live pointers and
+ *   merging runs of dead ones into free pointers. Counts the bytes still in use
+ *   as it goes.
+ *
+ *   chunk: The chunk to sweep.
+ *   bin: Whether the free pointers go on the bins; region chunks are only ever
+ *   bumped from, so theirs don't until the chunk is promoted.
+ *   returns: The number of bytes that were reclaimed.
+ */
+
+static size_t sweepChunk(struct chunk *chunk, int bin) {
+  size_t reclaimed = 0;
+  struct header *run = NULL;
+  for (char *p = chunk -> data; p < chunk -> top; ) {
+    struct header *header = (struct header *) p;
+    char *next = p + sizeof(struct header) + objectSize(header);
+    if (header -> kind != FREE_KIND && header -> mark) {
+      header -> mark = 0;
+      bytesInUse += sizeof(struct header) + objectSize(header);
+      countLive(header, 1);
+      if (run != NULL) {
+        run -> size = p - (char *)(run + 1);
+        if (bin) {
+          pushFree(run, run -> size);
+        }
+        run = NULL;
+      }
+    }
+    else {
+      if (header -> kind != FREE_KIND) {
+        reclaimed += sizeof(struct header) + objectSize(header);
+        header -> kind = FREE_KIND;
+      }
+      if (run == NULL) {
+        run = header;
+      }
+    }
+    p = next;
+  }
+  if (run != NULL) {
+    if (chunk == current || chunk == regionCurrent) {
+      chunk -> top = (char *) run;
+    }
+    else {
+      run -> size = chunk -> top - (char *)(run + 1);
+      if (bin) {
+        pushFree(run, run -> size);
+      }
+    }
+  }
+  return reclaimed;
+}
+
+/* Function: anyMarked
+ * --------------------
+ *   Checks whether any pointer in a chunk is marked.
+ *
+ *   chunk: The chunk to check.
+ *   returns: 1 if a pointer in the chunk is marked, 0 otherwise.
+ */
+
+static int anyMarked(struct chunk *chunk) {
+  for (char *p = chunk -> data; p < chunk -> top; ) {
+    struct header *header = (struct header *) p;
+    if (header -> kind != FREE_KIND && header -> mark) {
+      return 1;
+    }
+    p += sizeof(struct header) + objectSize(header);
+  }
+  return 0;
+}
+
+/* Function: sweepList
+ * --------------------
+ *   Sweeps every chunk in a list, releasing the chunks left with nothing live
+ *   in them.
+ *
+ *   list: The list of chunks to sweep.
+ *   bin: Whether the free pointers go on the bins.
+ *   returns: The number of bytes that were reclaimed.
+ */
+
+static size_t sweepList(struct chunk **list, int bin) {
+  size_t reclaimed = 0;
+  struct chunk **link = list;
+  while (*link != NULL) {
+    struct chunk *chunk = *link;
+    if (!anyMarked(chunk) && chunk != current && chunk != regionCurrent) {
+      for (char *p = chunk -> data; p < chunk -> top; ) {
+        struct header *header = (struct header *) p;
+        if (header -> kind != FREE_KIND) {
+          reclaimed += sizeof(struct header) + objectSize(header);
+        }
+        p += sizeof(struct header) + objectSize(header);
+      }
+      *link = chunk -> next;
+      releaseChunk(chunk);
+      continue;
+    }
+    reclaimed += sweepChunk(chunk, bin);
+    link = &chunk -> next;
+  }
+  return reclaimed;
+}
+
+/* Function: sweep
+ * --------------------
+ *   Sweeps the heap and the open region, rebuilding the bins from scratch.
+ */
+
+static void sweep() {
+  memset(bins, 0, sizeof(bins));
+  bytesInUse = 0;
+  for (int i = 0; i < MEMORY_COUNTERS; i++) {
+    counters[i].liveObjects = 0;
+    counters[i].liveBytes = 0;
+  }
+  stats.bytesReclaimed += sweepList(&chunklist, 1);
+  stats.bytesReclaimed += sweepList(&regionlist, 0);
+
+  // Nothing on the frame stack is reclaimed, but it gets marked all the same.
+  for (struct chunk *chunk = stacklist; chunk != NULL; chunk = chunk -> next) {
+    for (char *p = chunk -> data; p < chunk -> top; ) {
+      struct header *header = (struct header *) p;
+      header -> mark = 0;
+      p += sizeof(struct header) + objectSize(header);
+    }
+  }
+}
+
+/* Function: gcCollect
+ * --------------------
+ *   Runs a full mark-and-sweep collection, then sets the threshold for the
+ *   next one according to the heap-growth policy.
+ */
+
+void gcCollect() {
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  mark();
+  for (int i = 0; i < weakTableCount; i++) {
+    weakTables[i]();
+  }
+  sweep();
+
+  stats.liveAfterLast = bytesInUse;
+  gcThreshold = (size_t)(bytesInUse * gcGrowth);
+  if (gcThreshold < gcMinHeap) {
+    gcThreshold = gcMinHeap;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double pause = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+  stats.collections++;
+  stats.totalPause += pause;
+  if (pause > stats.maxPause) {
+    stats.maxPause = pause;
+  }
+}
+
+/* Function: gcWriteBarrier
+ * --------------------
+ *   Records that a pointer was written into another one. If the pointer
+ *   written belongs to the open region and the one it was written into
+ *   doesn't, the pointer has escaped the region, so the one written into is
+ *   remembered, to be fixed up when the region closes.
+ *
+ *   holder: The pointer that was written into.
+ *   pointer: The pointer that was written.
+ */
+
+void gcWriteBarrier(void *holder, void *pointer) {
+  if (!regionOpen || holder == NULL || pointer == NULL || !IS_POINTER(pointer)) {
+    return;
+  }
+  struct header *holderHeader = (struct header *) holder - 1;
+  struct header *header = (struct header *) pointer - 1;
+  if ((header -> flags & REGION_FLAG) && !(holderHeader -> flags & (REGION_FLAG | STACK_FLAG))) {
+    if (rememberedCount == rememberedCapacity) {
+      remembered = growArray(remembered, &rememberedCapacity, sizeof(void *));
+    }
+    remembered[rememberedCount++] = holder;
+  }
+}
+
+/* Function: regionBegin
+ * --------------------
+ *   Opens a region; everything allocated until regionEnd belongs to it.
+ */
+
+void regionBegin() {
+  regionOpen = 1;
+  rememberedCount = 0;
+}
+
+/* Function: evacuate
+ * --------------------
+ *   Copies a pointer out of the closing region into the heap, the first time
+ *   it is reached, leaving the address of the copy behind in its place. The
+ *   copy is pushed onto the mark stack so its own fields get fixed up.
+ *
+ *   pointer: The pointer in the region.
+ *   returns: The copy in the heap.
+ */
+
+static void *evacuate(void *pointer) {
+  struct header *header = (struct header *) pointer - 1;
+  if (header -> flags & FORWARDED_FLAG) {
+    return *(void **) pointer;
+  }
+  void *copy;
+  if (header -> flags & CDR_NEXT_FLAG) {
+    // A cell of a run is copied on its own, so its cdr has to be written out.
+    Value *cell = pointer;
+    copy = allocate(sizeof(struct ConsCell), VALUE_KIND, CONS_TYPE) + 1;
+    ((Value *) copy) -> c.car = cell -> c.car;
+    ((Value *) copy) -> c.cdr = (Value *) ((char *) pointer + sizeof(struct header) + sizeof(Value *));
+  }
+  else {
+    copy = allocate(header -> size, header -> kind, header -> type) + 1;
+    memcpy(copy, pointer, header -> size);
+  }
+  stats.regionBytesPromoted += sizeof(struct header) + objectSize(header);
+  header -> flags |= FORWARDED_FLAG;
+  *(void **) pointer = copy;
+  if (header -> kind != RAW_KIND) {
+    if (markCount == markCapacity) {
+      markStack = growArray(markStack, &markCapacity, sizeof(void *));
+    }
+    markStack[markCount++] = copy;
+  }
+  return copy;
+}
+
+/* Function: evacuateField
+ * --------------------
+ *   Points a field that points into the closing region at the copy of what it
+ *   points to.
+ *
+ *   field: The address of the field.
+ */
+
+static void evacuateField(void **field) {
+  if (*field != NULL && IS_POINTER(*field) && (((struct header *) *field - 1) -> flags & REGION_FLAG)) {
+    *field = evacuate(*field);
+  }
+}
+
+/* Function: regionEnd
+ * --------------------
+ *   Closes the open region. Whatever escaped it, found through the roots, the
+ *   protected slots and the pointers remembered by gcWriteBarrier, is copied
+ *   into the heap along with everything in the region it points to. The chunks
+ *   of the region are then released whole, without looking at anything else
+ *   in them.
+ */
+
+void regionEnd() {
+  regionOpen = 0;
+  for (int i = 0; i < rootCount; i++) {
+    evacuateField(roots[i]);
+  }
+  for (int i = 0; i < protectedCount; i++) {
+    evacuateField(protected[i]);
+  }
+  for (int i = 0; i < rememberedCount; i++) {
+    visitFields(remembered[i], evacuateField);
+  }
+  while (markCount > 0) {
+    visitFields(markStack[--markCount], evacuateField);
+  }
+  rememberedCount = 0;
+
+  regionCurrent = NULL;
+  while (regionlist != NULL) {
+    struct chunk *chunk = regionlist;
+    regionlist = chunk -> next;
+    for (char *p = chunk -> data; p < chunk -> top; ) {
+      struct header *header = (struct header *) p;
+      if (header -> kind != FREE_KIND) {
+        bytesInUse -= sizeof(struct header) + objectSize(header);
+        countLive(header, -1);
+        stats.regionBytesReclaimed += sizeof(struct header) + objectSize(header);
+      }
+      p += sizeof(struct header) + objectSize(header);
+    }
+    releaseChunk(chunk);
+  }
+  stats.regions++;
+}
+
+/* Function: gcSafePoint
+ * --------------------
+ *   Called by the evaluator wherever every pointer it still needs is reachable
+ *   from a root or a protected slot. Collects if the heap has grown past the
+ *   threshold.
+ */
+
+void gcSafePoint() {
+  if (gcEnabled && bytesInUse > gcThreshold) {
+    gcCollect();
+  }
+}
+
+/* Function: gcConfigure
+ * --------------------
+ *   Sets the heap-growth policy of the collector.
+ *
+ *   enabled: Whether collections happen at all.
+ *   minHeap: The number of bytes in use below which no collection happens.
+ *   growth: How much the heap may grow, relative to what survived the last
+ *   collection, before the next collection happens.
+ */
+
+void gcConfigure(int enabled, size_t minHeap, double growth) {
+  gcEnabled = enabled;
+  gcMinHeap = minHeap;
+  gcGrowth = growth;
+  gcThreshold = minHeap;
+}
+
+/* Function: gcPrintStats
+ * --------------------
+ *   Prints a report of the collections that happened to stderr.
+ */
+
+void gcPrintStats() {
+  fprintf(stderr, "GC: %ld collections, %.3f ms total pause, %.3f ms max pause, %.3f ms average pause\n",
+          stats.collections, stats.totalPause, stats.maxPause,
+          stats.collections ? stats.totalPause / stats.collections : 0.0);
+  fprintf(stderr, "GC: %zu bytes allocated, %zu bytes reclaimed, %zu bytes live after last collection\n",
+          stats.bytesAllocated, stats.bytesReclaimed, stats.liveAfterLast);
+  fprintf(stderr, "GC: %zu bytes heap, %zu bytes peak heap\n",
+          stats.heapSize, stats.peakHeapSize);
+  if (stats.regions > 0) {
+    fprintf(stderr, "GC: %ld regions, %zu bytes reclaimed by regions, %zu bytes promoted out of regions\n",
+            stats.regions, stats.regionBytesReclaimed, stats.regionBytesPromoted);
+  }
+}
+
+/* Function: memoryCounters
+ * --------------------
+ *   Gives read access to the memory counters.
+ *
+ *   returns: The array of MEMORY_COUNTERS counters.
+ */
+
+const struct memoryCounter *memoryCounters() {
+  return counters;
+}
+
+/* Function: memoryCounterName
+ * --------------------
+ *   Names what a memory counter counts.
+ *
+ *   counter: The index of the counter.
+ *   returns: Its name.
+ */
+
+const char *memoryCounterName(int counter) {
+  static const char *names[MEMORY_COUNTERS] = {
+    "int", "double", "string", "cons", "null", "pointer", "open", "close",
+    "boolean", "symbol", "void", "closure", "primitive", "local", "unspecified",
+    "frame", "raw"
+  };
+  return names[counter];
+}
+
+/* Function: memoryLiveBytes
+ * --------------------
+ *   returns: The number of bytes handed out by talloc and not yet reclaimed,
+ *   headers included.
+ */
+
+size_t memoryLiveBytes() {
+  return bytesInUse;
+}
+
+/* Function: memoryPeakBytes
+ * --------------------
+ *   returns: The most bytes that were ever in use at once.
+ */
+
+size_t memoryPeakBytes() {
+  return peakBytesInUse;
+}
+
+/* Function: stackPeakBytes
+ * --------------------
+ *   returns: The most bytes that were ever in use on the frame stack at once.
+ */
+
+size_t stackPeakBytes() {
+  return peakStackBytes;
+}
+
+/* Function: memPrintReport
+ * --------------------
+ *   Prints the memory counters to stderr, skipping what was never allocated.
+ */
+
+void memPrintReport() {
+  fprintf(stderr, "Memory: %zu bytes live, %zu bytes peak\n", bytesInUse, peakBytesInUse);
+  fprintf(stderr, "Memory: %-12s %12s %12s %12s %12s\n",
+          "object", "live", "live bytes", "allocated", "alloc bytes");
+  for (int i = 0; i < MEMORY_COUNTERS; i++) {
+    if (counters[i].allocatedObjects == 0 && counters[i].liveObjects == 0) {
+      continue;
+    }
+    fprintf(stderr, "Memory: %-12s %12zu %12zu %12zu %12zu\n", memoryCounterName(i),
+            counters[i].liveObjects, counters[i].liveBytes,
+            counters[i].allocatedObjects, counters[i].allocatedBytes);
+  }
+}
+
+/* Function: heapProfileEnable
+ * --------------------
+ *   Starts charging every allocation to the current allocation site.
+ */
+
+void heapProfileEnable() {
+  profiling = 1;
+}
+
+/* Function: heapProfileSite
+ * --------------------
+ *   Sets the allocation site that allocations are charged to from now on.
+ *
+ *   site: The new site, such as the expression being evaluated, or NULL.
+ *   returns: The site it replaces, so that it can be restored.
+ */
+
+void *heapProfileSite(void *site) {
+  void *previous = profileSite;
+  profileSite = site;
+  return previous;
+}
+
+/* Function: heapProfileSites
+ * --------------------
+ *   The counters of every site that has allocated something, in the order
+ *   they were first seen.
+ *
+ *   count: Set to the number of counters.
+ *   returns: The counters.
+ */
+
+const struct siteCounter *heapProfileSites(int *count) {
+  *count = siteCount;
+  return sites;
 }
 
 /* Function: tfree
  * --------------------
- *   Function that free's all pointers allocated by talloc, and the memory
- *   allocated for the global list to hold these pointers.
+ *   Function that free's all pointers allocated by talloc, by freeing every
+ *   chunk in the global list at once.
  */
 
 void tfree() {
-  struct node* current = globallist;
-  while (current != NULL) {
-    struct node* temp = current -> next;
-    free(current -> data);
-    free(current);
-    current = temp;
+  struct chunk *lists[] = {chunklist, regionlist, sparelist, stacklist, permanentlist};
+  for (int i = 0; i < 5; i++) {
+    struct chunk *chunk = lists[i];
+    while (chunk != NULL) {
+      struct chunk *temp = chunk -> next;
+      free(chunk);
+      chunk = temp;
+    }
   }
-  globallist = NULL;
+  chunklist = NULL;
+  current = NULL;
+  regionlist = NULL;
+  regionCurrent = NULL;
+  sparelist = NULL;
+  stacklist = NULL;
+  stackBytes = 0;
+  peakStackBytes = 0;
+  permanentlist = NULL;
+  regionOpen = 0;
+  memset(bins, 0, sizeof(bins));
+  memset(counters, 0, sizeof(counters));
+  bytesInUse = 0;
+  peakBytesInUse = 0;
+  stats.heapSize = 0;
+  free(roots);
+  free(protected);
+  free(markStack);
+  free(remembered);
+  free(sites);
+  free(siteIndex);
+  roots = NULL;
+  protected = NULL;
+  markStack = NULL;
+  remembered = NULL;
+  sites = NULL;
+  siteIndex = NULL;
+  siteCount = siteCapacity = siteIndexCapacity = 0;
+  lastSite = -1;
+  rememberedCount = rememberedCapacity = 0;
+  rootCount = rootCapacity = 0;
+  protectedCount = protectedCapacity = 0;
+  markCount = markCapacity = 0;
 }
 
 /* Function: texit
@@ -64,4 +1529,4 @@ void tfree() {
 void texit(int status){
   tfree();
   exit(status);
-}
\ No newline at end of file
+}
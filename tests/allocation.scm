@@ -0,0 +1,10 @@
+(define build (lambda (n acc) (if (= n 0) acc (build (- n 1) (cons n acc)))))
+(define sum (lambda (l acc) (if (null? l) acc (sum (cdr l) (+ acc (car l))))))
+(define mk (lambda (x) (lambda (y) (+ x y))))
+(define rep (lambda (n r) (if (= n 0) r (rep (- n 1) (sum (build 100 (quote ())) ((mk n) 0))))))
+(rep 2000 0)
+(define adders (build 50 (quote ())))
+(define map1 (lambda (f l) (if (null? l) (quote ()) (cons (f (car l)) (map1 f (cdr l))))))
+(map1 (lambda (x) (* x x)) adders)
+(let ((a (build 10 (quote ()))) (b 3)) (cons b a))
+(letrec ((f (lambda (n) (if (= n 0) 0 (+ n (f (- n 1))))))) (f 1000))
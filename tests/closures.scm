@@ -0,0 +1,23 @@
+(define build (lambda (n acc) (if (= n 0) acc (build (- n 1) (cons n acc)))))
+(define map1 (lambda (f l) (if (null? l) (quote ()) (cons (f (car l)) (map1 f (cdr l))))))
+(define mk (lambda (x) (lambda (y) (+ x y))))
+(map1 (lambda (n) ((mk n) 1.5)) (build 30 (quote ())))
+(define counter (let ((n 0)) (lambda () (set! n (+ n 1)) n)))
+(counter)
+(counter)
+(define g (lambda (a b c) (let* ((x (cons a b)) (y (cons x c))) (letrec ((h (lambda (k) (if (= k 0) y (h (- k 1)))))) (h 5)))))
+(g 1 2 3)
+(define deep (lambda (n) (if (= n 0) (quote ()) (cons (cons n (quote (a b c))) (deep (- n 1))))))
+(define len (lambda (l) (if (null? l) 0 (+ 1 (len (cdr l))))))
+(len (deep 2000))
+(cond ((null? (quote (1))) 1) ((car (quote (#f))) 2) (else (cons 3 4)))
+(and 1 (cons 1 2))
+(or #f (cons 3 4))
+(define s (quote "hello"))
+s
+(define fib (lambda (n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2))))))
+(fib 18)
+(define x 1)
+(set! x (cons x x))
+x
+(map1 (lambda (p) (car p)) (deep 5))
@@ -0,0 +1,5 @@
+(define build (lambda (n) (if (= n 0) (quote ()) (cons n (build (- n 1))))))
+(define len (lambda (l) (if (null? l) 0 (+ 1 (len (cdr l))))))
+(len (build 3000000))
+(define sum (lambda (n) (if (= n 0) 0 (+ n (sum (- n 1))))))
+(sum 1000000)
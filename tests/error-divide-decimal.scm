@@ -0,0 +1,3 @@
+(/ 7.5 3)
+(/ 5.0 0)
+(/ 1 2)
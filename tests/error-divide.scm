@@ -0,0 +1,4 @@
+(define f (lambda (n) (/ 10 n)))
+(f 5)
+(f 0)
+(f 1)
@@ -0,0 +1,2 @@
+(modulo 10 3)
+(modulo 7 0)
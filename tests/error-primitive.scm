@@ -0,0 +1 @@
+(car 1 2)
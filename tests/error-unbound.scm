@@ -0,0 +1 @@
+(let* ((a b) (b 5)) b)
@@ -0,0 +1,29 @@
+(define fib (lambda (n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2))))))
+(fib 20)
+(define x 5)
+(let ((a 1) (b 2)) (+ a b x))
+(let* ((a 1) (b (+ a 1))) (* a b))
+(letrec ((even? (lambda (n) (if (= n 0) #t (odd? (- n 1))))) (odd? (lambda (n) (if (= n 0) #f (even? (- n 1)))))) (even? 100))
+(cond ((< 1 0) 1) ((> 1 0) 2) (else 3))
+(and 1 2 3)
+(or #f #f)
+(car (quote (1 2 3)))
+(cdr (quote (1 2 3)))
+(cons 1 2)
+(cons 1 (quote ()))
+(null? (quote ()))
+(begin 1 2 3)
+(set! x 10)
+x
+(/ 9 3)
+(/ 10 4)
+(modulo 10 3)
+(* 2 3.5)
+(+ 1.5 2)
+(define make-counter (lambda () (let ((n 0)) (lambda () (set! n (+ n 1)) n))))
+(define c (make-counter))
+(c)
+(c)
+(lambda (x) x)
+(quote (a b (c d)))
+(= 1 1)
@@ -0,0 +1,9 @@
+(define build (lambda (n acc) (if (= n 0) acc (build (- n 1) (cons n acc)))))
+(define keep (build 20 (quote ())))
+(define churn (lambda (n) (if (= n 0) (car keep) (begin (build 20 (quote ())) (churn (- n 1))))))
+(churn 100)
+(define adder (lambda (x) (lambda (y) (+ x y))))
+(define add5 (adder 5))
+(churn 100)
+(add5 10)
+keep
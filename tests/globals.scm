@@ -0,0 +1,21 @@
+(define a 1)
+(define b 2)
+(define get-a (lambda () a))
+(get-a)
+(define a 10)
+(get-a)
+(set! a (+ a b))
+(get-a)
+(define f (lambda (x) (+ x b)))
+(f 1)
+(define b 100)
+(f 1)
+(define f (lambda (x) (* x b)))
+(f 2)
+(define use-later (lambda () later))
+(define later 7)
+(use-later)
+(set! later (cons later later))
+(use-later)
+(define many (lambda (n) (if (= n 0) a (many (- n 1)))))
+(many 50)
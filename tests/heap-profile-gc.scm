@@ -0,0 +1,64 @@
+(define build (lambda (n acc) (if (= n 0) acc (build (- n 1) (cons n acc)))))
+(car (build 20 (quote ())))
+(car (build 21 (quote ())))
+(car (build 22 (quote ())))
+(car (build 23 (quote ())))
+(car (build 24 (quote ())))
+(car (build 25 (quote ())))
+(car (build 26 (quote ())))
+(car (build 27 (quote ())))
+(car (build 28 (quote ())))
+(car (build 29 (quote ())))
+(car (build 30 (quote ())))
+(car (build 31 (quote ())))
+(car (build 32 (quote ())))
+(car (build 33 (quote ())))
+(car (build 34 (quote ())))
+(car (build 35 (quote ())))
+(car (build 36 (quote ())))
+(car (build 37 (quote ())))
+(car (build 38 (quote ())))
+(car (build 39 (quote ())))
+(car (build 40 (quote ())))
+(car (build 41 (quote ())))
+(car (build 42 (quote ())))
+(car (build 43 (quote ())))
+(car (build 44 (quote ())))
+(car (build 45 (quote ())))
+(car (build 46 (quote ())))
+(car (build 47 (quote ())))
+(car (build 48 (quote ())))
+(car (build 49 (quote ())))
+(car (build 50 (quote ())))
+(car (build 51 (quote ())))
+(car (build 52 (quote ())))
+(car (build 53 (quote ())))
+(car (build 54 (quote ())))
+(car (build 55 (quote ())))
+(car (build 56 (quote ())))
+(car (build 57 (quote ())))
+(car (build 58 (quote ())))
+(car (build 59 (quote ())))
+(car (build 60 (quote ())))
+(car (build 61 (quote ())))
+(car (build 62 (quote ())))
+(car (build 63 (quote ())))
+(car (build 64 (quote ())))
+(car (build 65 (quote ())))
+(car (build 66 (quote ())))
+(car (build 67 (quote ())))
+(car (build 68 (quote ())))
+(car (build 69 (quote ())))
+(car (build 70 (quote ())))
+(car (build 71 (quote ())))
+(car (build 72 (quote ())))
+(car (build 73 (quote ())))
+(car (build 74 (quote ())))
+(car (build 75 (quote ())))
+(car (build 76 (quote ())))
+(car (build 77 (quote ())))
+(car (build 78 (quote ())))
+(car (build 79 (quote ())))
+(define keep (build 300 (quote ())))
+(define pairs (lambda (n acc) (if (= n 0) acc (pairs (- n 1) (cons (cons n 1.5) acc)))))
+(car (pairs 200 (quote ())))
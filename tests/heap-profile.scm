@@ -0,0 +1,5 @@
+(define build (lambda (n acc) (if (= n 0) acc (build (- n 1) (cons n acc)))))
+(define keep (build 200 (quote ())))
+(define pairs (lambda (n acc) (if (= n 0) acc (pairs (- n 1) (cons (cons n 1.5) acc)))))
+(pairs 50 (quote ()))
+(let ((a (build 10 (quote ())))) (cons 0 a))
@@ -0,0 +1,5 @@
+(define sq (lambda (x) (* x x)))
+(define loop (lambda (n acc) (if (= n 0) acc (loop (- n 1) (+ acc (sq 3))))))
+(loop 1000 0)
+(define once (lambda (x) (+ x 1)))
+(once 1)
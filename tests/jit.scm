@@ -0,0 +1,22 @@
+(define add (lambda (a b) (+ a b)))
+(define loop (lambda (n acc) (if (= n 0) acc (loop (- n 1) (add acc 2305843009213693951)))))
+(loop 150 0)
+(define big (lambda (a) (+ a a)))
+(define lp2 (lambda (n x) (if (= n 0) x (lp2 (- n 1) (big 1)))))
+(lp2 200 0)
+(big 4611686018427387903)
+(big (* 2147483647 2147483647))
+(big 1.5)
+(define cmp (lambda (a b) (if (< a b) -1 (if (> a b) 1 0))))
+(define lp3 (lambda (n) (if (= n 0) (cmp 1 2) (begin (cmp n 2.5) (lp3 (- n 1))))))
+(lp3 200)
+(cmp 3 2.5)
+(cmp 2 2)
+(define f (lambda (x) (* x 2)))
+(define lp4 (lambda (n acc) (if (= n 0) acc (lp4 (- n 1) (f n)))))
+(lp4 300 0)
+(define f (lambda (x) (* x 3)))
+(lp4 300 0)
+(set! + (lambda (a b) (* a b)))
+(add 3 4)
+(lp2 1 0)
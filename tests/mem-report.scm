@@ -0,0 +1,5 @@
+(define build (lambda (n acc) (if (= n 0) acc (build (- n 1) (cons n acc)))))
+(define keep (build 100 (quote ())))
+(define adder (lambda (x) (lambda (y) (+ x y))))
+((adder 1.5) 2)
+(build 5 (quote ()))
@@ -0,0 +1,9 @@
+(define live (lambda (stats) (car (cdr (car stats)))))
+(define peak (lambda (stats) (car (cdr (car (cdr stats))))))
+(> (live (memory-stats)) 0)
+(define build (lambda (n acc) (if (= n 0) acc (build (- n 1) (cons n acc)))))
+(define before (live (memory-stats)))
+(define keep (build 100 (quote ())))
+(> (live (memory-stats)) before)
+(< (live (memory-stats)) (peak (memory-stats)))
+(null? (cdr (cdr (memory-stats))))
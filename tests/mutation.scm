@@ -0,0 +1,18 @@
+(define make-counter (lambda () (let ((n 0)) (lambda () (begin (set! n (+ n 1)) n)))))
+(define c (make-counter))
+(c)
+(c)
+(define lst (quote ()))
+(define push (lambda (x) (set! lst (cons x lst))))
+(push (cons 1.5 2.5))
+(push (cons 3 4))
+lst
+(define cell (let ((v (cons 1 2))) (lambda (x) (begin (set! v (cons x v)) v))))
+(cell 10)
+(cell 20)
+(define build (lambda (n acc) (if (= n 0) acc (build (- n 1) (cons n acc)))))
+(define saved (build 5 (quote ())))
+(build 1000 (quote ()))
+saved
+(c)
+(cell 30)
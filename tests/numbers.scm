@@ -0,0 +1,31 @@
+(define loop (lambda (n acc) (if (= n 0) acc (loop (- n 1) (+ acc 1)))))
+(loop 1000000 0)
+(define build (lambda (n) (if (= n 0) (quote ()) (cons n (build (- n 1))))))
+(define len (lambda (l) (if (null? l) 0 (+ 1 (len (cdr l))))))
+(len (build 10000))
+4611686018427387903
+4611686018427387904
+-4611686018427387904
+(* 4611686018427387903 2)
+(+ 4611686018427387903 1)
+(- -4611686018427387904 1)
+(define big (* 2147483647 2147483647))
+big
+(* big 2)
+(+ big big)
+(- (- 0 big) big)
+(* 100000 100000)
+(* 3037000499 3037000499)
+(* 3037000500 3037000500)
+(- 5)
+(- 5.5)
+(+)
+(*)
+(+ 1 2 3 4)
+(< 1 2.5)
+(> 2.5 1)
+(= 1 1.0)
+(/ -9 3)
+(modulo 17 5)
+(+ 1.5 2 3 4 5 6 7 8 9 10 11 12)
+(/ 1 0.0)
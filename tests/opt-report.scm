@@ -0,0 +1,6 @@
+(define k 10)
+(define sq (lambda (x) (* x x)))
+(define f (lambda (n) (+ (sq n) (sq k) (if (< 1 2) 100 200))))
+(f 3)
+(define kk (+ k 1))
+kk
@@ -0,0 +1,12 @@
+(define k 10)
+(define sq (lambda (x) (* x x)))
+(define l (quote (1 2 3)))
+(define f (lambda (n) (+ (sq n) (sq k) (car l) (if (< 1 2) 100 200))))
+(f 3)
+(sq k)
+(define g (lambda (n) (sq (+ n 1))))
+(g 2)
+(define k2 (+ k 1))
+k2
+(define sq2 (lambda (x) (sq x)))
+(sq2 5)
@@ -0,0 +1,62 @@
+#!/bin/sh
+# tests/run.sh
+# --------------------
+# Runs every program in tests/ under the evaluator, a heap small enough to
+# collect often, --regions, --vm, --jit and --opt, and as a program compiled
+# from the C that --emit-c makes of it, and compares each output with the
+# .expected file next to it. A program with a .flags file is only run with the
+# flags in it, and what it prints on stderr, with every number masked, is
+# compared with its .report file, or must be empty without one.
+#
+# usage: sh tests/run.sh <C compiler> <sources to link the emitted C with>
+
+CC=$1
+shift
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+failed=0
+
+# The rest of the interpreter is compiled once, for every emitted program.
+OBJECTS=
+for source in "$@"; do
+  object=$WORK/$(basename "$source" .c).o
+  $CC -c "$source" -o "$object" || exit 1
+  OBJECTS="$OBJECTS $object"
+done
+
+check() {
+  if ! diff "$2" "$3" > "$WORK/diff"; then
+    echo "FAIL: $1"
+    cat "$WORK/diff"
+    failed=$((failed + 1))
+  fi
+}
+
+for program in tests/*.scm; do
+  expected=${program%.scm}.expected
+  flags=${program%.scm}.flags
+  if [ -f "$flags" ]; then
+    report=${program%.scm}.report
+    [ -f "$report" ] || report=/dev/null
+    ./interpreter $(cat "$flags") < "$program" > "$WORK/out" 2> "$WORK/err"
+    check "$program $(cat "$flags")" "$expected" "$WORK/out"
+    sed 's/ *-*[0-9][0-9.]*/ N/g' "$WORK/err" > "$WORK/masked"
+    check "$program $(cat "$flags") (report)" "$report" "$WORK/masked"
+    continue
+  fi
+  for mode in "" --gc-min-heap=4096 --regions --vm --jit --opt; do
+    ./interpreter $mode < "$program" > "$WORK/out" 2>&1
+    check "$program ${mode:-(default)}" "$expected" "$WORK/out"
+  done
+  rm -f "$WORK/out"
+  ./interpreter --emit-c < "$program" > "$WORK/program.c" &&
+    $CC -I. -o "$WORK/program" "$WORK/program.c" $OBJECTS &&
+    "$WORK/program" > "$WORK/out" 2>&1
+  check "$program --emit-c" "$expected" "$WORK/out"
+done
+
+if [ $failed -ne 0 ]; then
+  echo "$failed failed"
+  exit 1
+fi
+echo "All tests passed"
@@ -0,0 +1,4 @@
+(define fib (lambda (n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2))))))
+(fib 15)
+(define loop (lambda (n) (if (= n 0) 0 (loop (- n 1)))))
+(loop 1000)
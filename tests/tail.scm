@@ -0,0 +1,11 @@
+(define loop (lambda (n acc) (if (= n 0) acc (loop (- n 1) (+ acc 1)))))
+(loop 1000000 0)
+(define even? (lambda (n) (if (= n 0) #t (odd? (- n 1)))))
+(define odd? (lambda (n) (if (= n 0) #f (even? (- n 1)))))
+(even? 1000001)
+(define count (lambda (n) (cond ((= n 0) 0) (else (let ((m (- n 1))) (count m))))))
+(count 1000000)
+(define via-and (lambda (n) (and #t (if (= n 0) 1 (via-and (- n 1))))))
+(via-and 1000000)
+(define via-begin (lambda (n) (begin 1 (if (= n 0) 2 (via-begin (- n 1))))))
+(via-begin 1000000)
@@ -23,9 +23,231 @@
 #include <string.h>
 #include <stdio.h>
 #include <assert.h>
+#include <stdint.h>
+#include <errno.h>
 #include "headers/linkedlist.h"
 #include "headers/value.h"
 #include "headers/talloc.h"
+#include "headers/tokenizer.h"
+
+// The position of the last character read, and of the one before it, so that
+// it can be put back. Lines and columns are counted from 1.
+static int line = 1;
+static int column = 0;
+static int previousLine = 1;
+static int previousColumn = 0;
+
+// The spans given to recordSpan, in an open-addressed table keyed by node.
+// The table is weak: the entry of a node is dropped once it is collected.
+struct spanEntry {
+  Value *node;
+  struct sourceSpan span;
+};
+static struct spanEntry *spans = NULL;
+static int spanCount = 0;
+static int spanCapacity = 0;
+
+// The interned symbols, in an open-addressed table keyed by name.
+static Value **symbols = NULL;
+static int symbolCount = 0;
+static int symbolCapacity = 0;
+
+/* Function: spanSlot
+ * --------------------
+ *   Finds the slot of the span table that holds a node, or the empty slot
+ *   where it would go.
+ *
+ *   table: The span table.
+ *   capacity: Its number of slots, a power of two.
+ *   node: The node to look for.
+ *   returns: The slot.
+ */
+
+static struct spanEntry *spanSlot(struct spanEntry *table, int capacity, Value *node) {
+  uintptr_t h = (uintptr_t) node;
+  h ^= h >> 17;
+  h *= 0x9E3779B97F4A7C15ull;
+  int slot = (int) (h >> 32) & (capacity - 1);
+  while (table[slot].node != NULL && table[slot].node != node) {
+    slot = (slot + 1) & (capacity - 1);
+  }
+  return &table[slot];
+}
+
+/* Function: pruneSpans
+ * --------------------
+ *   Drops the spans of the nodes that the collection in progress is about to
+ *   reclaim. Removing an entry from the table would break the probe sequence
+ *   of the entries after it, so the live ones are put back from scratch.
+ */
+
+static void pruneSpans() {
+  struct spanEntry *live = malloc(sizeof(struct spanEntry) * (spanCount + 1));
+  if (live == NULL) {
+    printf("Memory error: out of memory. \n");
+    texit(1);
+  }
+  int count = 0;
+  for (int i = 0; i < spanCapacity; i++) {
+    if (spans[i].node != NULL && gcIsLive(spans[i].node)) {
+      live[count] = spans[i];
+      count = count + 1;
+    }
+  }
+  memset(spans, 0, sizeof(struct spanEntry) * spanCapacity);
+  for (int i = 0; i < count; i++) {
+    *spanSlot(spans, spanCapacity, live[i].node) = live[i];
+  }
+  spanCount = count;
+  free(live);
+}
+
+/* Function: recordSpan
+ * --------------------
+ *   Records where a parse node came from in the source. The table is doubled
+ *   whenever it gets half full. Its keys aren't traced by the collector, which
+ *   has pruneSpans drop the entry of a node before the node is swept, so a
+ *   node allocated at the same address later doesn't inherit its span.
+ *
+ *   node: The node; nothing is recorded for an immediate.
+ *   span: Where it starts and ends.
+ */
+
+void recordSpan(Value *node, const struct sourceSpan *span) {
+  if (!IS_POINTER(node)) {
+    return;
+  }
+  if (2 * (spanCount + 1) > spanCapacity) {
+    int capacity = spanCapacity == 0 ? 256 : spanCapacity * 2;
+    struct spanEntry *table = talloc(sizeof(struct spanEntry) * capacity);
+    memset(table, 0, sizeof(struct spanEntry) * capacity);
+    for (int i = 0; i < spanCapacity; i++) {
+      if (spans[i].node != NULL) {
+        *spanSlot(table, capacity, spans[i].node) = spans[i];
+      }
+    }
+    if (spans == NULL) {
+      gcAddRoot(&spans);
+      gcAddWeakTable(pruneSpans);
+    }
+    spans = table;
+    spanCapacity = capacity;
+  }
+  struct spanEntry *entry = spanSlot(spans, spanCapacity, node);
+  if (entry -> node == NULL) {
+    spanCount = spanCount + 1;
+  }
+  entry -> node = node;
+  entry -> span = *span;
+}
+
+/* Function: findSpan
+ * --------------------
+ *   Looks up where a parse node came from in the source.
+ *
+ *   node: The node.
+ *   returns: Its span, or NULL if none was recorded.
+ */
+
+const struct sourceSpan *findSpan(Value *node) {
+  if (spanCapacity == 0 || !IS_POINTER(node)) {
+    return NULL;
+  }
+  struct spanEntry *entry = spanSlot(spans, spanCapacity, node);
+  return entry -> node == NULL ? NULL : &entry -> span;
+}
+
+/* Function: symbolSlot
+ * --------------------
+ *   Finds the slot of the symbol table that holds the symbol with a given
+ *   name, or the empty slot where it would go.
+ *
+ *   table: The symbol table.
+ *   capacity: Its number of slots, a power of two.
+ *   name: The name to look for.
+ *   returns: The slot.
+ */
+
+static Value **symbolSlot(Value **table, int capacity, const char *name) {
+  uint32_t h = 2166136261u;
+  for (const char *c = name; *c != '\0'; c++) {
+    h = (h ^ (unsigned char) *c) * 16777619u;
+  }
+  int slot = h & (capacity - 1);
+  while (table[slot] != NULL && strcmp(table[slot] -> s, name)) {
+    slot = (slot + 1) & (capacity - 1);
+  }
+  return &table[slot];
+}
+
+/* Function: intern
+ * --------------------
+ *   Finds the one symbol with the given name, creating it the first time the
+ *   name is seen. Symbols and the table are permanent, so they can be compared
+ *   by pointer for as long as the interpreter runs. The table is doubled
+ *   whenever it gets half full.
+ *
+ *   name: The name of the symbol.
+ *   returns: The SYMBOL_TYPE Value struct for that name.
+ */
+
+Value *intern(const char *name) {
+  if (2 * (symbolCount + 1) > symbolCapacity) {
+    int capacity = symbolCapacity == 0 ? 256 : symbolCapacity * 2;
+    Value **table = tallocPermanent(sizeof(Value *) * capacity);
+    memset(table, 0, sizeof(Value *) * capacity);
+    for (int i = 0; i < symbolCapacity; i++) {
+      if (symbols[i] != NULL) {
+        *symbolSlot(table, capacity, symbols[i] -> s) = symbols[i];
+      }
+    }
+    symbols = table;
+    symbolCapacity = capacity;
+  }
+  Value **slot = symbolSlot(symbols, symbolCapacity, name);
+  if (*slot == NULL) {
+    Value *symbol = tallocPermanentValue(SYMBOL_TYPE);
+    symbol -> s = tallocPermanent(sizeof(char) * (strlen(name) + 1));
+    strcpy(symbol -> s, name);
+    *slot = symbol;
+    symbolCount = symbolCount + 1;
+  }
+  return *slot;
+}
+
+/* Function: readChar
+ * --------------------
+ *   Reads the next character from stdin, keeping track of its position.
+ *
+ *   returns: The character.
+ */
+
+static char readChar() {
+  char ch = (char)fgetc(stdin);
+  previousLine = line;
+  previousColumn = column;
+  if (ch == '\n') {
+    line = line + 1;
+    column = 0;
+  }
+  else {
+    column = column + 1;
+  }
+  return ch;
+}
+
+/* Function: unreadChar
+ * --------------------
+ *   Puts back the character that was just read, along with its position.
+ *
+ *   ch: The character.
+ */
+
+static void unreadChar(char ch) {
+  ungetc(ch, stdin);
+  line = previousLine;
+  column = previousColumn;
+}
 
 /* Function: concatenate
  * --------------------
@@ -55,6 +277,27 @@ static char *concatenate (char *str, char ch) {
   return str;
 }
 
+/* Function: makeInteger
+ * --------------------
+ *   Reads the text of an integer literal. Integers are 63-bit fixnums, so a
+ *   literal that doesn't fit in one, or even in a long long, is read as a
+ *   decimal instead of being cut short.
+ *
+ *   text: The digits of the literal, with its sign if it has one.
+ *   returns: A fixnum, or a DOUBLE_TYPE Value struct.
+ */
+
+static Value *makeInteger(char *text) {
+  errno = 0;
+  long long number = strtoll(text, NULL, 10);
+  if (errno != ERANGE && FITS_FIXNUM((intptr_t) number)) {
+    return MAKE_FIXNUM((intptr_t) number);
+  }
+  Value *val = tallocValue(DOUBLE_TYPE);
+  val -> d = strtod(text, NULL);
+  return val;
+}
+
 /* Function: tokenize
  * --------------------
  *   Function that reads all of the input from stdin, and returens a linked List
@@ -69,16 +312,17 @@ Value *tokenize() {
   char identifiersigns[] = "+-";
   char initialsym[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ!$%&*/:<=>?~_^";
   char subseqsym[] = "0123456789.+-";
-  charRead = (char)fgetc(stdin);
+  charRead = readChar();
   char *conc = NULL;
   Value *error_list = makeNull();
 
   while (charRead != EOF) {
     conc = NULL;
+    Value *previous = list;
+    struct sourceSpan span = {line, column, line, column};
     if (charRead == '(') {
       conc = concatenate(conc, charRead);
-      Value *val = talloc(sizeof(Value));
-      val -> type = OPEN_TYPE;
+      Value *val = tallocValue(OPEN_TYPE);
       char *text = conc;
       val -> s = talloc(sizeof(char) * (strlen(text) + 1));
       strcpy(val -> s,text);
@@ -87,8 +331,7 @@ Value *tokenize() {
 
     else if (charRead == ')') {
       conc = concatenate(conc, charRead);
-      Value *val = talloc(sizeof(Value));
-      val -> type = CLOSE_TYPE;
+      Value *val = tallocValue(CLOSE_TYPE);
       char *text = conc;
       val -> s = talloc(sizeof(char) * (strlen(text) + 1));
       strcpy(val -> s,text);
@@ -97,16 +340,12 @@ Value *tokenize() {
 
     else if (strchr(identifiersigns, charRead) != NULL) { //read a <sign>
       char nextchar;
-      nextchar = (char)fgetc(stdin);
+      nextchar = readChar();
       if (nextchar == ' ' || nextchar == EOF || nextchar == '\n' || nextchar == ')' || nextchar == '(') { // only read <sign>
         conc = concatenate(conc, charRead);
-        Value *val = talloc(sizeof(Value));
-        char *text = conc;
-        val -> type = SYMBOL_TYPE;
-        val -> s = talloc(sizeof(char) * (strlen(text) + 1));
-        strcpy(val -> s, text);
+        Value *val = intern(conc);
         list = cons(val, list);
-        ungetc(nextchar, stdin);
+        unreadChar(nextchar);
       }
 
       else if (strchr(initialsym, nextchar) != NULL) {
@@ -118,7 +357,7 @@ Value *tokenize() {
         conc = concatenate(conc, charRead);
         if (nextchar == '.') { // reads decimal after sign
           conc = concatenate(conc, nextchar);
-          char charafterdecimal = (char)fgetc(stdin);
+          char charafterdecimal = readChar();
 
           if (strchr(numbers, charafterdecimal) == NULL) {
             printf("Syntax error \n");
@@ -128,19 +367,18 @@ Value *tokenize() {
           while (charafterdecimal != EOF || charafterdecimal != ' ' || charafterdecimal != '\n') { // <sign> then <udecimal> -> . <digit>+
             if (strchr(numbers, charafterdecimal) != NULL) {
               conc = concatenate(conc, charafterdecimal);
-              charafterdecimal = (char)fgetc(stdin);
+              charafterdecimal = readChar();
             }
             else {
               break;
             }
           }
 
-          ungetc(charafterdecimal, stdin);
+          unreadChar(charafterdecimal);
           double number;
           char *ptr;
-          Value *val = talloc(sizeof(Value));
+          Value *val = tallocValue(DOUBLE_TYPE);
           number = strtod(conc, &ptr);
-          val -> type = DOUBLE_TYPE;
           val -> d = number;
           list = cons(val, list);
           conc = NULL;
@@ -154,30 +392,24 @@ Value *tokenize() {
                 decimalFlag = 1;
               }
               conc = concatenate(conc, nextchar);
-              nextchar = (char)fgetc(stdin);
+              nextchar = readChar();
             }
             else {
               break;
             }
           }
 
-          ungetc(nextchar, stdin);
+          unreadChar(nextchar);
           if (decimalFlag == 0) {
-            long number;
-            char *ptr;
-            Value *val = talloc(sizeof(Value));
-            number = strtol(conc, &ptr, 10);
-            val -> type = INT_TYPE;
-            val -> i = number;
+            Value *val = makeInteger(conc);
             list = cons(val, list);
             conc = NULL;
           }
           else if (decimalFlag == 1) {
             double number;
             char *ptr;
-            Value *val = talloc(sizeof(Value));
+            Value *val = tallocValue(DOUBLE_TYPE);
             number = strtod(conc, &ptr);
-            val -> type = DOUBLE_TYPE;
             val -> d = number;
             list = cons(val, list);
             conc = NULL;
@@ -193,16 +425,12 @@ Value *tokenize() {
 
     else if (strchr(initialsym, charRead) != NULL) { // read <initial>
       char nextchar;
-      nextchar = (char)fgetc(stdin);
+      nextchar = readChar();
       if (nextchar == EOF || nextchar == ' ' || nextchar == '\n' || nextchar == ')' || nextchar == '(') { // just <initial>
         conc = concatenate(conc, charRead);
-        Value *val = talloc(sizeof(Value));
-        char *text = conc;
-        val -> type = SYMBOL_TYPE;
-        val -> s = talloc(sizeof(char) * (strlen(text) +1));
-        strcpy(val->s,text);
+        Value *val = intern(conc);
         list = cons(val, list);
-        ungetc(nextchar, stdin);
+        unreadChar(nextchar);
       }
       else { // read <initial> <subsequent>+
         conc = concatenate(conc, charRead);
@@ -214,7 +442,7 @@ Value *tokenize() {
           texit(0);
         }
         while (charRead != EOF || charRead != ' ') {
-          charRead = (char)fgetc(stdin);
+          charRead = readChar();
           if (strchr(initialsym, charRead) != NULL || strchr(subseqsym, charRead) != NULL) {
             conc = concatenate(conc, charRead);
           }
@@ -222,19 +450,15 @@ Value *tokenize() {
             break;
           }
         }
-        ungetc(charRead, stdin);
-        Value *val = talloc(sizeof(Value));
-        char *text = conc;
-        val -> type = SYMBOL_TYPE;
-        val -> s = talloc(sizeof(char)*(strlen(text) + 1));
-        strcpy(val->s,text);
+        unreadChar(charRead);
+        Value *val = intern(conc);
         list = cons(val, list);
       }
     }
 
     else if (charRead == '.') { // reads decimal
       conc = concatenate(conc, charRead);
-      char charafterdecimal = (char)fgetc(stdin);
+      char charafterdecimal = readChar();
       if (strchr(numbers, charafterdecimal) == NULL) {
         printf("Syntax error \n");
         texit(0);
@@ -242,18 +466,17 @@ Value *tokenize() {
       while (charafterdecimal != EOF || charafterdecimal != ' ') { // <udecimal> ->  . <digit>+
         if (strchr(numbers, charafterdecimal) != NULL) {
           conc = concatenate(conc, charafterdecimal);
-          charafterdecimal = (char)fgetc(stdin);
+          charafterdecimal = readChar();
         }
         else {
           break;
         }
       }
-      ungetc(charafterdecimal, stdin);
+      unreadChar(charafterdecimal);
       double number;
       char *ptr;
-      Value *val = talloc(sizeof(Value));
+      Value *val = tallocValue(DOUBLE_TYPE);
       number = strtod(conc, &ptr);
-      val -> type = DOUBLE_TYPE;
       val -> d = number;
       list = cons(val, list);
       conc = NULL;
@@ -267,29 +490,23 @@ Value *tokenize() {
             decimalFlag = 1;
           }
           conc = concatenate(conc, charRead);
-          charRead = (char)fgetc(stdin);
+          charRead = readChar();
         }
         else {
           break;
         }
       }
-      ungetc(charRead, stdin);
+      unreadChar(charRead);
       if (decimalFlag == 0) {
-        long number;
-        char *ptr;
-        Value *val = talloc(sizeof(Value));
-        number = strtol(conc, &ptr, 10);
-        val -> type = INT_TYPE;
-        val -> i = number;
+        Value *val = makeInteger(conc);
         list = cons(val, list);
         conc = NULL;
       }
       else if (decimalFlag == 1) {
         double number;
         char *ptr;
-        Value *val = talloc(sizeof(Value));
+        Value *val = tallocValue(DOUBLE_TYPE);
         number = strtod(conc, &ptr);
-        val -> type = DOUBLE_TYPE;
         val -> d = number;
         list = cons(val, list);
         conc = NULL;
@@ -302,38 +519,29 @@ Value *tokenize() {
 
     else if (charRead == '#') {
       char nextchar;
-      nextchar = (char)fgetc(stdin);
-      if (nextchar == 'f' || nextchar == 't') {
-        conc = concatenate(conc, charRead);
-        conc = concatenate(conc, nextchar);
-      }
-      else {
+      nextchar = readChar();
+      if (nextchar != 'f' && nextchar != 't') {
         printf("Syntax error \n");
         texit(0);
       }
-      Value *val = talloc(sizeof(Value));
-      val -> type = BOOL_TYPE;
-      char *text = conc;
-      val -> s = talloc(sizeof(char)*(strlen(text) + 1));
-      strcpy(val -> s,text);
+      Value *val = MAKE_BOOL(nextchar == 't');
       list = cons(val,list);
     }
 
     else if (charRead == '"') {
       conc = concatenate(conc, charRead);
-      charRead = (char)fgetc(stdin);
+      charRead = readChar();
       while (charRead != EOF) {
         conc = concatenate(conc, charRead);
         if (charRead == '"') {
-          Value *val = talloc(sizeof(Value));
+          Value *val = tallocValue(STR_TYPE);
           char *text = conc;
-          val -> type  = STR_TYPE;
           val -> s = talloc(sizeof(char)*(strlen(text) + 1));
           strcpy(val->s,text);
           list = cons(val, list);
           break;
         }
-        charRead = (char)fgetc(stdin);
+        charRead = readChar();
       }
       if (charRead == EOF) {
         printf("Syntax error \n");
@@ -346,7 +554,7 @@ Value *tokenize() {
         if (charRead == '\n') {
           break;
         }
-        charRead = (char)fgetc(stdin);
+        charRead = readChar();
       }
     }
 
@@ -355,7 +563,12 @@ Value *tokenize() {
       texit(0);
     }
 
-    charRead = (char)fgetc(stdin);
+    if (list != previous && TYPE(car(list)) != SYMBOL_TYPE) {
+      span.endLine = line;
+      span.endColumn = column;
+      recordSpan(car(list), &span);
+    }
+    charRead = readChar();
   }
 
   Value *revList = reverse(list);
@@ -372,9 +585,9 @@ Value *tokenize() {
 void displayTokens(Value *list) {
   Value *cur = list;
   while (cur != NULL) {
-    switch (cur -> type) {
+    switch (TYPE(cur)) {
       case INT_TYPE:
-        printf("%i:integer\n", car(cur) -> i);
+        printf("%li:integer\n", (long) FIXNUM_VALUE(car(cur)));
         cur = cdr(cur);
         break;
       case DOUBLE_TYPE:
@@ -386,34 +599,33 @@ void displayTokens(Value *list) {
         cur = cdr(cur);
         break;
       case CONS_TYPE:
-        if (car(cur) -> type == INT_TYPE) {
-          printf("%i:integer\n", car(cur) -> i);
+        if (TYPE(car(cur)) == INT_TYPE) {
+          printf("%li:integer\n", (long) FIXNUM_VALUE(car(cur)));
         }
-        else if (car(cur) -> type == DOUBLE_TYPE) {
+        else if (TYPE(car(cur)) == DOUBLE_TYPE) {
           printf("%f:double\n", car(cur) -> d);
         }
-        else if (car(cur) -> type == STR_TYPE) {
+        else if (TYPE(car(cur)) == STR_TYPE) {
           printf("%s:string\n", car(cur) -> s);
         }
-        else if (car(cur) -> type == PTR_TYPE) {
+        else if (TYPE(car(cur)) == PTR_TYPE) {
           printf("Address = %p \n", car(cur) -> p);
         }
-        else if (car(cur) -> type == OPEN_TYPE) {
+        else if (TYPE(car(cur)) == OPEN_TYPE) {
           printf("%s:open\n", car(cur) -> s);
         }
-        else if (car(cur) -> type == CLOSE_TYPE) {
+        else if (TYPE(car(cur)) == CLOSE_TYPE) {
           printf("%s:close\n", car(cur) -> s);
         }
-        else if (car(cur) -> type == BOOL_TYPE) {
-          printf("%s:boolean\n", car(cur) -> s);
+        else if (TYPE(car(cur)) == BOOL_TYPE) {
+          printf("%s:boolean\n", car(cur) == TRUE_VALUE ? "#t" : "#f");
         }
-        else if (car(cur) -> type == SYMBOL_TYPE) {
+        else if (TYPE(car(cur)) == SYMBOL_TYPE) {
           printf("%s:symbol\n", car(cur) -> s);
         }
         cur = cdr(cur);
         break;
       case NULL_TYPE:
-        cur = cdr(cur);
         goto exit_loop;
       case PTR_TYPE:
         printf("Address = %p", car(cur) -> p);
@@ -427,7 +639,7 @@ void displayTokens(Value *list) {
         cur = cdr(cur);
         break;
       case BOOL_TYPE:
-        printf("%s:boolean\n", car(cur) -> s);
+        printf("%s:boolean\n", car(cur) == TRUE_VALUE ? "#t" : "#f");
         cur = cdr(cur);
         break;
       case SYMBOL_TYPE:
@@ -440,6 +652,8 @@ void displayTokens(Value *list) {
         break;
       case PRIMITIVE_TYPE:
         break;
+      case LOCAL_TYPE:
+        break;
       case UNSPECIFIED_TYPE:
         break;
     }
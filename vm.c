@@ -0,0 +1,868 @@
+/* vm.c
+ * Author: Khalid Hussain
+ * --------------------
+ * This program is the virtual machine of --vm. Each top-level expression is
+ * analyzed by interpreter.c, then compiled with the body of every lambda in
+ * it to bytecode, which runBytecode runs with a stack of values in the frame
+ * of each call and a stack of return addresses, instead of recursing in C.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include "headers/linkedlist.h"
+#include "headers/value.h"
+#include "headers/talloc.h"
+#include "headers/interpreter.h"
+#include "headers/arithmetic.h"
+#include "headers/node.h"
+#include "headers/vm.h"
+
+/* The bytecode of the body of a lambda, or of a top-level expression. A call
+ * gets one frame, whose first slots are the parameters, then the stack of the
+ * virtual machine for the body, and last the frame of the caller, so that
+ * the collector finds every frame in use from the current one. Like nodes,
+ * code lives as long as the interpreter.
+ */
+
+struct Code {
+  int *instructions;
+  void **literals; /* The constants, symbols and nodes the instructions refer to */
+  int params; /* The number of parameters */
+  int stackSize; /* The most values the body has on the stack at once */
+};
+
+/* The code being compiled, in buffers that grow as needed, and how deep the
+ * stack is at the instruction being compiled. */
+struct compiler {
+  int *instructions;
+  int length;
+  int capacity;
+  void **literals;
+  int literalCount;
+  int literalCapacity;
+  int depth;
+  int maxDepth;
+};
+
+/* Where a call returns to: the code, frame and stack of the caller, and the
+ * top of the frame stack before the frame of the call was made. The frame of
+ * the caller is also in the last slot of the frame of the call, which is how
+ * the collector gets to it, so this doesn't need to be traced. */
+struct returnAddress {
+  int *pc;
+  Code *code;
+  Frame *frame;
+  Value **sp;
+  void *mark;
+};
+
+static struct returnAddress *returnStack = NULL;
+static int returnCount = 0;
+static int returnCapacity = 0;
+
+/* What printStackStats reports: the calls the virtual machine made, how
+ * deep they went, and what growing returnStack for them cost. */
+static struct {
+  long calls;
+  long tailCalls;
+  int peakDepth;
+  long growths;
+  double growTime;
+} stackStats;
+
+/* The arguments of a tail call, kept here while the frame they are in is
+ * released. */
+static Value **tailArguments = NULL;
+static int tailCapacity = 0;
+
+#define IS_PRIMITIVE(v, f) (IS_POINTER(v) && HEAP_TYPE(v) == PRIMITIVE_TYPE && (v) -> prim.pf == (f))
+
+static void compileNode(struct compiler *c, Node *node, int tail);
+
+/* Function: emit
+ * --------------------
+ *   Appends an opcode or an operand to the code being compiled.
+ *
+ *   c: The compiler.
+ *   word: The opcode or operand.
+ *   returns: Where it is in the instructions.
+ */
+
+static int emit(struct compiler *c, int word) {
+  c -> instructions = growBuffer(c -> instructions, &c -> capacity, c -> length + 1, sizeof(int));
+  c -> instructions[c -> length] = word;
+  c -> length = c -> length + 1;
+  return c -> length - 1;
+}
+
+/* Function: emitLiteral
+ * --------------------
+ *   Appends an operand that refers to a constant, symbol or node, which is
+ *   added to the literals of the code being compiled.
+ *
+ *   c: The compiler.
+ *   literal: The constant, symbol or node.
+ */
+
+static void emitLiteral(struct compiler *c, void *literal) {
+  c -> literals = growBuffer(c -> literals, &c -> literalCapacity, c -> literalCount + 1, sizeof(void *));
+  c -> literals[c -> literalCount] = literal;
+  emit(c, c -> literalCount);
+  c -> literalCount = c -> literalCount + 1;
+}
+
+/* Function: emitJump
+ * --------------------
+ *   Appends a jump whose target isn't known yet. Jumps to the same target are
+ *   chained through their operands until patchJumps fills them in.
+ *
+ *   c: The compiler.
+ *   op: The jump instruction.
+ *   chain: The last jump to the same target, or -1 if there is none.
+ *   returns: The new chain.
+ */
+
+static int emitJump(struct compiler *c, opcode op, int chain) {
+  emit(c, op);
+  return emit(c, chain);
+}
+
+/* Function: patchJumps
+ * --------------------
+ *   Points a chain of jumps at the next instruction to be compiled.
+ *
+ *   c: The compiler.
+ *   chain: The last jump of the chain, or -1 if there is none.
+ */
+
+static void patchJumps(struct compiler *c, int chain) {
+  while (chain >= 0) {
+    int next = c -> instructions[chain];
+    c -> instructions[chain] = c -> length;
+    chain = next;
+  }
+}
+
+/* Function: arithmeticOpcode
+ * --------------------
+ *   Works out whether a call is one of the arithmetic or comparison
+ *   primitives on two arguments that the virtual machine has instructions
+ *   for. Those still check that the variable is bound to the primitive when
+ *   they run, since it could have been redefined.
+ *
+ *   node: A CALL_NODE.
+ *   returns: The instruction, or -1 if there is none.
+ */
+
+int arithmeticOpcode(Node *node) {
+  static char *names[] = {"+", "-", "<", ">", "="};
+  static opcode ops[] = {OP_ADD, OP_SUB, OP_LESS, OP_GREATER, OP_EQUAL};
+  if (node -> count != 3 || node -> children[0] -> kind != GLOBAL_NODE) {
+    return -1;
+  }
+  for (int i = 0; i < 5; i++) {
+    if (!strcmp(node -> children[0] -> value -> s, names[i])) {
+      return ops[i];
+    }
+  }
+  return -1;
+}
+
+/* Function: compileCode
+ * --------------------
+ *   Compiles the body of a lambda, or a top-level expression, to bytecode
+ *   that returns its value.
+ *
+ *   body: The node to compile.
+ *   params: The number of parameters, which take the first slots of the frame.
+ *   returns: The code, copied out of the buffers of the compiler.
+ */
+
+static Code *compileCode(Node *body, int params) {
+  struct compiler c = {NULL, 0, 0, NULL, 0, 0, 0, 0};
+  compileNode(&c, body, 1);
+
+  Code *code = tallocPermanent(sizeof(Code));
+  code -> instructions = tallocPermanent(c.length * sizeof(int));
+  memcpy(code -> instructions, c.instructions, c.length * sizeof(int));
+  code -> literals = tallocPermanent((c.literalCount + 1) * sizeof(void *));
+  if (c.literalCount > 0) {
+    memcpy(code -> literals, c.literals, c.literalCount * sizeof(void *));
+  }
+  code -> params = params;
+  code -> stackSize = c.maxDepth;
+  free(c.instructions);
+  free(c.literals);
+  return code;
+}
+
+/* Function: compileTopLevel
+ * --------------------
+ *   Compiles a top-level expression, along with the body of every lambda in
+ *   it, to bytecode for the virtual machine.
+ *
+ *   node: The analyzed expression.
+ *   returns: Its code.
+ */
+
+Code *compileTopLevel(Node *node) {
+  return compileCode(node, 0);
+}
+
+/* Function: compileNode
+ * --------------------
+ *   Compiles a node to instructions that leave its value on top of the stack
+ *   or, in tail position, return it. Calls in tail position become tail
+ *   calls, which reuse the frame of the call they are in.
+ *
+ *   c: The compiler.
+ *   node: The node to compile.
+ *   tail: Whether the value of the node is the value of the code.
+ */
+
+static void compileNode(struct compiler *c, Node *node, int tail) {
+  int depth = c -> depth;
+  int chain = -1;
+  int op;
+
+  switch (node -> kind) {
+  case CONSTANT_NODE:
+    emit(c, OP_CONSTANT);
+    emitLiteral(c, node -> value);
+    break;
+
+  case LOCAL_NODE:
+    if (LOCAL_MUTABLE(node -> value)) {
+      emit(c, OP_MUTABLE_LOCAL);
+      emit(c, LOCAL_DEPTH(node -> value));
+    }
+    else if (LOCAL_DEPTH(node -> value) > 0) {
+      emit(c, OP_LOCAL);
+      emit(c, LOCAL_DEPTH(node -> value));
+    }
+    else {
+      emit(c, OP_LOCAL_HERE);
+    }
+    emit(c, LOCAL_SLOT(node -> value));
+    break;
+
+  case GLOBAL_NODE:
+    emit(c, OP_GLOBAL);
+    emitLiteral(c, node -> value);
+    break;
+
+  case ERROR_NODE:
+    emit(c, OP_ERROR);
+    emitLiteral(c, node);
+    break;
+
+  case IF_NODE:
+    compileNode(c, node -> children[0], 0);
+    chain = emitJump(c, OP_JUMP_IF_FALSE, -1);
+    c -> depth = depth;
+    compileNode(c, node -> children[1], tail);
+    if (!tail) {
+      int end = emitJump(c, OP_JUMP, -1);
+      patchJumps(c, chain);
+      chain = end;
+    }
+    else {
+      patchJumps(c, chain);
+      chain = -1;
+    }
+    c -> depth = depth;
+    compileNode(c, node -> children[2], tail);
+    patchJumps(c, chain);
+    break;
+
+  case LET_NODE:
+    for (int i = 0; i < node -> slots; i++) {
+      compileNode(c, node -> children[i], 0);
+      emit(c, OP_CHECK_LET);
+      emitLiteral(c, node);
+      emit(c, i);
+    }
+    emit(c, OP_LET);
+    emitLiteral(c, node);
+    c -> depth = depth;
+    compileNode(c, node -> children[node -> slots], tail);
+    if (!tail) {
+      emit(c, OP_LEAVE);
+    }
+    break;
+
+  case LETREC_NODE:
+    emit(c, OP_LETREC);
+    emitLiteral(c, node);
+    for (int i = 0; i < node -> slots; i++) {
+      compileNode(c, node -> children[i], 0);
+      emit(c, OP_CHECK_LETREC);
+    }
+    emit(c, OP_LETREC_SET);
+    emit(c, node -> slots);
+    c -> depth = depth;
+    compileNode(c, node -> children[node -> slots], tail);
+    if (!tail) {
+      emit(c, OP_LEAVE);
+    }
+    break;
+
+  case SET_LOCAL_NODE:
+    compileNode(c, node -> children[0], 0);
+    emit(c, OP_SET_LOCAL);
+    emit(c, LOCAL_DEPTH(node -> value));
+    emit(c, LOCAL_SLOT(node -> value));
+    break;
+
+  case SET_GLOBAL_NODE:
+    emit(c, OP_CHECK_GLOBAL);
+    emitLiteral(c, node -> value);
+    compileNode(c, node -> children[0], 0);
+    emit(c, OP_SET_GLOBAL);
+    emitLiteral(c, node -> value);
+    break;
+
+  case DEFINE_NODE:
+    compileNode(c, node -> children[0], 0);
+    emit(c, OP_DEFINE);
+    emitLiteral(c, node -> value);
+    break;
+
+  case LAMBDA_NODE:
+    if (node -> code == NULL) {
+      node -> code = compileCode(node -> children[0], node -> slots);
+    }
+    emit(c, OP_CLOSURE);
+    emitLiteral(c, node);
+    break;
+
+  case BEGIN_NODE:
+    if (node -> count == 0) {
+      emit(c, OP_CONSTANT);
+      emitLiteral(c, VOID_VALUE);
+      break;
+    }
+    for (int i = 0; i < node -> count - 1; i++) {
+      compileNode(c, node -> children[i], 0);
+      emit(c, OP_POP);
+      c -> depth = depth;
+    }
+    compileNode(c, node -> children[node -> count - 1], tail);
+    break;
+
+  case AND_NODE:
+  case OR_NODE:
+    // A #f from the last expression is returned as it is, so it can be a
+    // tail call.
+    if (node -> count == 0) {
+      emit(c, OP_CONSTANT);
+      emitLiteral(c, node -> kind == AND_NODE ? TRUE_VALUE : FALSE_VALUE);
+      break;
+    }
+    for (int i = 0; i < node -> count - 1; i++) {
+      compileNode(c, node -> children[i], 0);
+      chain = emitJump(c, node -> kind == AND_NODE ? OP_AND : OP_OR, chain);
+      c -> depth = depth;
+    }
+    compileNode(c, node -> children[node -> count - 1], tail);
+    patchJumps(c, chain);
+    break;
+
+  case COND_NODE:
+    for (int i = 0; i < node -> count; i += 2) {
+      compileNode(c, node -> children[i], 0);
+      int next = emitJump(c, OP_JUMP_IF_FALSE, -1);
+      c -> depth = depth;
+      compileNode(c, node -> children[i + 1], tail);
+      if (!tail) {
+        chain = emitJump(c, OP_JUMP, chain);
+      }
+      c -> depth = depth;
+      patchJumps(c, next);
+    }
+    emit(c, OP_CONSTANT);
+    emitLiteral(c, VOID_VALUE);
+    patchJumps(c, chain);
+    break;
+
+  case CALL_NODE:
+    for (int i = 0; i < node -> count; i++) {
+      compileNode(c, node -> children[i], 0);
+    }
+    op = arithmeticOpcode(node);
+    if (op < 0) {
+      emit(c, tail ? OP_TAIL_CALL : OP_CALL);
+      emit(c, node -> count - 1);
+      emitLiteral(c, node);
+      c -> depth = depth + 1;
+      return;
+    }
+    emit(c, op);
+    emitLiteral(c, node);
+    break;
+
+  case NATIVE_NODE:
+    // The JIT is off with --vm, but a body it compiled is still the body
+    // it took the place of.
+    compileNode(c, node -> children[0], tail);
+    return;
+  }
+
+  c -> depth = depth + 1;
+  if (c -> depth > c -> maxDepth) {
+    c -> maxDepth = c -> depth;
+  }
+  if (tail && node -> kind != IF_NODE && node -> kind != LET_NODE && node -> kind != LETREC_NODE
+      && !(node -> kind == BEGIN_NODE && node -> count > 0)) {
+    emit(c, OP_RETURN);
+  }
+}
+
+/* Function: pushReturn
+ * --------------------
+ *   Remembers where a call made by the virtual machine returns to.
+ *
+ *   pc: The instruction after the call.
+ *   code: The code of the caller.
+ *   frame: The frame of the caller.
+ *   sp: The stack of the caller, without the function and its arguments.
+ *   mark: The top of the frame stack before the frame of the call is made.
+ */
+
+static void pushReturn(int *pc, Code *code, Frame *frame, Value **sp, void *mark) {
+  if (returnCount == returnCapacity) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    returnStack = growBuffer(returnStack, &returnCapacity, returnCount + 1, sizeof(struct returnAddress));
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    stackStats.growths++;
+    stackStats.growTime += (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+  }
+  struct returnAddress *address = &returnStack[returnCount];
+  address -> pc = pc;
+  address -> code = code;
+  address -> frame = frame;
+  address -> sp = sp;
+  address -> mark = mark;
+  returnCount = returnCount + 1;
+  if (returnCount > stackStats.peakDepth) {
+    stackStats.peakDepth = returnCount;
+  }
+}
+
+/* Function: chargedFrame
+ * --------------------
+ *   Makes a frame on the frame stack for the virtual machine, charging it to
+ *   the expression that needs it.
+ *
+ *   size: The number of slots.
+ *   site: The node of the call, let or letrec.
+ *   returns: The new frame.
+ */
+
+static Frame *chargedFrame(int size, Node *site) {
+  if (heapProfiling && IS_CONS(site -> source)) {
+    void *outerSite = heapProfileSite(site -> source);
+    Frame *frame = tallocStackFrame(size);
+    heapProfileSite(outerSite);
+    return frame;
+  }
+  return tallocStackFrame(size);
+}
+
+/* Function: enterClosure
+ * --------------------
+ *   Makes the frame of a call of a closure by the virtual machine, on the
+ *   frame stack. Missing arguments are left as the empty list, and extra ones
+ *   ignored.
+ *
+ *   function: The closure.
+ *   args: The arguments.
+ *   count: The number of arguments.
+ *   caller: The frame of the caller, which the call returns to.
+ *   call: The CALL_NODE of the call.
+ *   returns: The frame, with room for the stack of the body after the
+ *   parameters.
+ */
+
+static Frame *enterClosure(Value *function, Value **args, int count, Frame *caller, Node *call) {
+  Code *code = function -> cl.lambda -> code;
+  Frame *frame = chargedFrame(code -> params + code -> stackSize + 1, call);
+  frame -> parent = function -> cl.frame;
+  frame -> slots[frame -> size - 1] = (Value *) caller;
+  if (count > code -> params) {
+    count = code -> params;
+  }
+  for (int i = 0; i < count; i++) {
+    frame -> slots[i] = args[i];
+  }
+  return frame;
+}
+
+/* Function: makeClosure
+ * --------------------
+ *   Makes a closure for the virtual machine, charging it to the lambda.
+ *
+ *   lambda: The LAMBDA_NODE.
+ *   frame: The current frame of the virtual machine.
+ *   returns: The closure.
+ */
+
+static Value *makeClosure(Node *lambda, Frame *frame) {
+  if (heapProfiling && IS_CONS(lambda -> source)) {
+    void *outerSite = heapProfileSite(lambda -> source);
+    Value *closure = runLambda(lambda, frame);
+    heapProfileSite(outerSite);
+    return closure;
+  }
+  return runLambda(lambda, frame);
+}
+
+/* Function: runBytecode
+ * --------------------
+ *   The virtual machine, which runs the code of a top-level expression. Each
+ *   instruction jumps straight to the next one through the table of labels,
+ *   rather than going back to a loop. Calls of closures don't recurse in C:
+ *   where each returns to is kept in returnStack, and a tail call releases
+ *   the frame of the call it is in before making its own. The collector runs
+ *   at calls, its safe point, when every value in use is in a frame that the
+ *   current one leads to.
+ *
+ *   code: The code of the expression.
+ *   returns: The value of the expression.
+ */
+
+Value *runBytecode(Code *code) {
+  static void *dispatch[] = {
+    &&constant, &&localHere, &&local, &&mutableLocal, &&global, &&setLocal,
+    &&checkGlobal, &&setGlobal, &&define, &&jump, &&jumpIfFalse, &&and, &&or,
+    &&pop, &&checkLet, &&let, &&letRec, &&checkLetRec, &&letRecSet, &&leave,
+    &&closure, &&call, &&tailCall, &&add, &&sub, &&less, &&greater, &&equal,
+    &&ret, &&error
+  };
+  int base = returnCount;
+  pushReturn(NULL, NULL, NULL, NULL, stackMark());
+
+  Frame *frame = tallocStackFrame(code -> stackSize);
+  Value **sp = frame -> slots;
+  gcProtect(&frame);
+  int *pc = code -> instructions;
+  void **literals = code -> literals;
+  Value *function, *value, *result;
+  Frame *holder;
+  Node *node;
+  int count, i;
+
+#define NEXT goto *dispatch[*pc++]
+#define LITERAL ((void *) literals[*pc++])
+
+  NEXT;
+
+constant:
+  *sp++ = LITERAL;
+  NEXT;
+
+localHere:
+  *sp++ = frame -> slots[*pc++];
+  NEXT;
+
+local:
+  holder = frameAt(frame, pc[0]);
+  *sp++ = holder -> slots[pc[1]];
+  pc += 2;
+  NEXT;
+
+mutableLocal:
+  holder = frameAt(frame, pc[0]);
+  value = holder -> slots[pc[1]];
+  *sp++ = IS_BOX(value) ? ((Frame *) value) -> slots[0] : value;
+  pc += 2;
+  NEXT;
+
+global:
+  value = LITERAL;
+  {
+    Value **cell = globalCell(value);
+    if (cell == NULL) {
+      printf("Evaluation error: symbol '%s' not found. \n", value -> s);
+      texit(0);
+    }
+    *sp++ = *cell;
+  }
+  NEXT;
+
+setLocal:
+  holder = frameAt(frame, pc[0]);
+  value = holder -> slots[pc[1]];
+  if (IS_BOX(value)) {
+    holder = (Frame *) value;
+    holder -> slots[0] = sp[-1];
+  }
+  else {
+    holder -> slots[pc[1]] = sp[-1];
+  }
+  gcWriteBarrier(holder, sp[-1]);
+  sp[-1] = VOID_VALUE;
+  pc += 2;
+  NEXT;
+
+checkGlobal:
+  value = LITERAL;
+  if (globalCell(value) == NULL) {
+    printf("Evaluation error: symbol '%s' not found when trying to set. \n", value -> s);
+    texit(0);
+  }
+  NEXT;
+
+setGlobal:
+  *globalCell(LITERAL) = sp[-1];
+  gcWriteBarrier(globalframe, sp[-1]);
+  sp[-1] = VOID_VALUE;
+  NEXT;
+
+define:
+  defineGlobal(LITERAL, sp[-1]);
+  sp[-1] = VOID_VALUE;
+  NEXT;
+
+jump:
+  pc = code -> instructions + *pc;
+  NEXT;
+
+jumpIfFalse:
+  sp--;
+  pc = IS_TRUE(*sp) ? pc + 1 : code -> instructions + *pc;
+  NEXT;
+
+and:
+  if (!IS_TRUE(sp[-1])) {
+    pc = code -> instructions + *pc;
+    NEXT;
+  }
+  sp--;
+  pc++;
+  NEXT;
+
+or:
+  if (IS_TRUE(sp[-1])) {
+    pc = code -> instructions + *pc;
+    NEXT;
+  }
+  sp--;
+  pc++;
+  NEXT;
+
+pop:
+  sp--;
+  NEXT;
+
+checkLet:
+  node = LITERAL;
+  value = sp[-1];
+  if (TYPE(value) == CLOSURE_TYPE || value == UNSPECIFIED_VALUE) {
+    Value *binding = node -> value;
+    for (i = 0; i < *pc; i++) {
+      binding = cdr(binding);
+    }
+    printf("Evaluation error: Unbound variable %s in %s. \n", car(car(binding)) -> s, node -> text);
+    texit(0);
+  }
+  pc++;
+  NEXT;
+
+let:
+  node = LITERAL;
+  holder = chargedFrame(node -> slots, node);
+  holder -> parent = frame;
+  sp -= node -> slots;
+  for (i = 0; i < node -> slots; i++) {
+    holder -> slots[i] = sp[i];
+  }
+  frame = holder;
+  NEXT;
+
+letRec:
+  node = LITERAL;
+  holder = chargedFrame(node -> slots, node);
+  holder -> parent = frame;
+  for (i = 0; i < node -> slots; i++) {
+    holder -> slots[i] = UNSPECIFIED_VALUE;
+  }
+  frame = holder;
+  NEXT;
+
+checkLetRec:
+  if (sp[-1] == UNSPECIFIED_VALUE) {
+    printf("Evaluation error: Evaluated an UNSPECIFIED_TYPE in letrec. \n");
+    texit(0);
+  }
+  NEXT;
+
+letRecSet:
+  count = *pc++;
+  sp -= count;
+  for (i = 0; i < count; i++) {
+    if (IS_BOX(frame -> slots[i])) {
+      ((Frame *) frame -> slots[i]) -> slots[0] = sp[i];
+      gcWriteBarrier(frame -> slots[i], sp[i]);
+    }
+    else {
+      frame -> slots[i] = sp[i];
+    }
+  }
+  NEXT;
+
+leave:
+  frame = frame -> parent;
+  NEXT;
+
+closure:
+  node = LITERAL;
+  *sp++ = makeClosure(node, frame);
+  NEXT;
+
+call:
+  count = *pc++;
+  node = LITERAL;
+applyFunction:
+  gcSafePoint();
+  function = sp[-count - 1];
+  if (TYPE(function) == CLOSURE_TYPE) {
+    stackStats.calls++;
+    pushReturn(pc, code, frame, sp - count - 1, stackMark());
+    frame = enterClosure(function, sp - count, count, frame, node);
+    code = function -> cl.lambda -> code;
+    literals = code -> literals;
+    pc = code -> instructions;
+    sp = frame -> slots + code -> params;
+    NEXT;
+  }
+  result = applyPrimitive(function, sp - count, count, node);
+  sp -= count + 1;
+  *sp++ = result;
+  NEXT;
+
+tailCall:
+  count = *pc++;
+  node = LITERAL;
+  gcSafePoint();
+  function = sp[-count - 1];
+  if (TYPE(function) == CLOSURE_TYPE) {
+    stackStats.tailCalls++;
+    tailArguments = growBuffer(tailArguments, &tailCapacity, count, sizeof(Value *));
+    for (i = 0; i < count; i++) {
+      tailArguments[i] = sp[i - count];
+    }
+    stackRelease(returnStack[returnCount - 1].mark);
+    returnStack[returnCount - 1].mark = stackMark();
+    frame = enterClosure(function, tailArguments, count, returnStack[returnCount - 1].frame, node);
+    code = function -> cl.lambda -> code;
+    literals = code -> literals;
+    pc = code -> instructions;
+    sp = frame -> slots + code -> params;
+    NEXT;
+  }
+  result = applyPrimitive(function, sp - count, count, node);
+  goto returnResult;
+
+add:
+  node = LITERAL;
+  if (IS_FIXNUM(sp[-2]) && IS_FIXNUM(sp[-1]) && IS_PRIMITIVE(sp[-3], primitiveAdd)) {
+    value = numberAddFixnums(sp[-2], sp[-1]);
+    if (value != NULL) {
+      sp[-3] = value;
+      sp -= 2;
+      NEXT;
+    }
+  }
+  // An overflow is left to the primitive, which makes it a double.
+  count = 2;
+  goto applyFunction;
+
+sub:
+  node = LITERAL;
+  if (IS_FIXNUM(sp[-2]) && IS_FIXNUM(sp[-1]) && IS_PRIMITIVE(sp[-3], primitiveMinus)) {
+    value = numberMinusFixnums(sp[-2], sp[-1]);
+    if (value != NULL) {
+      sp[-3] = value;
+      sp -= 2;
+      NEXT;
+    }
+  }
+  count = 2;
+  goto applyFunction;
+
+less:
+  node = LITERAL;
+  if (IS_FIXNUM(sp[-2]) && IS_FIXNUM(sp[-1]) && IS_PRIMITIVE(sp[-3], primitiveLessThan)) {
+    sp[-3] = numberLessThanFixnums(sp[-2], sp[-1]);
+    sp -= 2;
+    NEXT;
+  }
+  count = 2;
+  goto applyFunction;
+
+greater:
+  node = LITERAL;
+  if (IS_FIXNUM(sp[-2]) && IS_FIXNUM(sp[-1]) && IS_PRIMITIVE(sp[-3], primitiveGreaterThan)) {
+    sp[-3] = numberGreaterThanFixnums(sp[-2], sp[-1]);
+    sp -= 2;
+    NEXT;
+  }
+  count = 2;
+  goto applyFunction;
+
+equal:
+  node = LITERAL;
+  if (IS_FIXNUM(sp[-2]) && IS_FIXNUM(sp[-1]) && IS_PRIMITIVE(sp[-3], primitiveEqual)) {
+    sp[-3] = numberEqualFixnums(sp[-2], sp[-1]);
+    sp -= 2;
+    NEXT;
+  }
+  count = 2;
+  goto applyFunction;
+
+ret:
+  result = sp[-1];
+returnResult:
+  returnCount = returnCount - 1;
+  stackRelease(returnStack[returnCount].mark);
+  if (returnCount == base) {
+    gcUnprotect(1);
+    return result;
+  }
+  pc = returnStack[returnCount].pc;
+  code = returnStack[returnCount].code;
+  frame = returnStack[returnCount].frame;
+  sp = returnStack[returnCount].sp;
+  literals = code -> literals;
+  *sp++ = result;
+  NEXT;
+
+error:
+  node = LITERAL;
+  printf("%s", node -> text);
+  texit(0);
+  return VOID_VALUE;
+
+#undef NEXT
+#undef LITERAL
+}
+
+/* Function: printStackStats
+ * --------------------
+ *   Prints how deep the calls of the virtual machine went, and what the
+ *   stacks that hold them cost, to stderr, so that the cost of deep recursion
+ *   can be told apart from the cost of evaluation. The frame stack is
+ *   reported for the tree of nodes too.
+ */
+
+void printStackStats() {
+  fprintf(stderr, "Stack: %ld calls, %ld tail calls, %d deepest\n",
+          stackStats.calls, stackStats.tailCalls, stackStats.peakDepth);
+  fprintf(stderr, "Stack: %zu bytes peak frame stack, %zu bytes of return addresses, %ld growths taking %.3f ms\n",
+          stackPeakBytes(), returnCapacity * sizeof(struct returnAddress),
+          stackStats.growths, stackStats.growTime);
+}